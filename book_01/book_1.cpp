@@ -1842,8 +1842,20 @@ using std::endl;
 #include <chrono>
 #include <codecvt>
 #include <future>       // async, future
-//#include <thread>       // this_thread
+#include <thread>       // this_thread
 #include <mutex>
+#include <algorithm>    // sort, nth_element
+#include <cmath>        // sqrt
+#include <cpuid.h>      // __get_cpuid
+#include <cerrno>       // EINTR
+#include <sys/resource.h> // getrusage
+#include <sys/mman.h>   // mmap, madvise
+#include <atomic>
+#include <immintrin.h>  // SSE2/AVX2 intrinsics
+#include <string_view>
+#include <array>
+#include <tuple>
+#include <numeric>      // iota
 
 auto print_hline = []() { cout << std::string(40,'~') << endl; };
 
@@ -2201,17 +2213,303 @@ long nanos() {
    return ts.tv_sec*1000000000L + ts.tv_nsec;
 }
 // https://stackoverflow.com/questions/13772567/how-to-get-the-cpu-cycle-count-in-x86-64-from-c
+// note: bare rdtsc is not serializing, the CPU may execute it before preceding
+//       (or after following) instructions -- for timing code use rdtsc_begin()/rdtsc_end()
 uint64_t rdtsc() {
    unsigned int lo,hi;
    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
    return ((uint64_t)hi << 32) | lo;
 }
+// fenced TSC reads, as in Intel's "How to Benchmark Code Execution Times on Intel IA-32 and IA-64"
+// - rdtsc_begin: lfence waits for all preceding instructions to complete before rdtsc is executed
+// - rdtsc_end:   rdtscp waits for all preceding instructions, lfence keeps following instructions
+//                from starting before the timestamp is read
+inline uint64_t rdtsc_begin() {
+   unsigned int lo,hi;
+   __asm__ __volatile__("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+   return ((uint64_t)hi << 32) | lo;
+}
+inline uint64_t rdtsc_end() {
+   unsigned int lo,hi,aux;
+   __asm__ __volatile__("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux) : : "memory");
+   return ((uint64_t)hi << 32) | lo;
+}
+// invariant TSC (CPUID.80000007H:EDX[8]): TSC ticks at a constant rate in all P-/C-states,
+// i.e. it's a wall clock and not a cycle counter
+bool has_invariant_tsc() {
+   unsigned int eax, ebx, ecx, edx;
+   if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+      return false;
+   }
+   return edx & (1u << 8);
+}
+/*
+   TSC as a clock: TSC frequency is measured once against CLOCK_MONOTONIC_RAW (i.e. nanos()),
+   on first use (tsc_clock::calibration() is a function-local static, so this is thread-safe)
+   - ticks_to_ns()/ns_to_ticks() convert between TSC ticks and ns
+   - now_ns() returns TSC-based timestamps on the same timescale as nanos(), without a syscall/vDSO call
+   only meaningful with an invariant TSC, otherwise TSC ticks are cycles of whatever frequency the core runs at
+*/
+struct tsc_clock {
+   struct calibration_t {
+      bool invariant;
+      double ticks_per_ns;
+      double ns_per_tick;
+      long base_ns;        // nanos() and rdtsc() taken at (about) the same time
+      uint64_t base_ticks;
+   };
+
+   static const calibration_t& calibration() {
+      static const calibration_t calib = calibrate();
+      return calib;
+   }
+   static bool invariant() { return calibration().invariant; }
+   static double ticks_per_ns() { return calibration().ticks_per_ns; }
+   static long ticks_to_ns(uint64_t ticks) { return (long) (ticks*calibration().ns_per_tick); }
+   static uint64_t ns_to_ticks(long ns) { return (uint64_t) (ns*calibration().ticks_per_ns); }
+   static long now_ns() {
+      const calibration_t& c = calibration();
+      return c.base_ns + (long) ((rdtsc_begin()-c.base_ticks)*c.ns_per_tick);
+   }
+
+private:
+   // take a (nanos, tsc) pair, retrying to get the one with the tightest nanos() bracket
+   static void sample_pair(long& ns, uint64_t& ticks) {
+      long best_bracket = std::numeric_limits<long>::max();
+      for (int i=0; i<100; ++i) {
+         long n1 = nanos();
+         uint64_t t = rdtsc_begin();
+         long n2 = nanos();
+         if (n2-n1 < best_bracket) {
+            best_bracket = n2-n1;
+            ns = n1 + (n2-n1)/2;
+            ticks = t;
+         }
+      }
+   }
+   static calibration_t calibrate(long calibration_ns = 50000000) {
+      calibration_t c;
+      c.invariant = has_invariant_tsc();
+      long ns1 = 0, ns2 = 0;
+      uint64_t ticks1 = 0, ticks2 = 0;
+      sample_pair(ns1, ticks1);
+      struct timespec ts = { 0, calibration_ns };
+      nanosleep(&ts, nullptr);
+      sample_pair(ns2, ticks2);
+      c.ticks_per_ns = (double) (ticks2-ticks1)/(ns2-ns1);
+      c.ns_per_tick  = 1.0/c.ticks_per_ns;
+      c.base_ns      = ns2;
+      c.base_ticks   = ticks2;
+      return c;
+   }
+};
+struct ns_split_in_units {
+   long m_ns;
+   explicit ns_split_in_units(long ns) : m_ns(ns) {}
+   friend std::ostream& operator<<(std::ostream& os, const ns_split_in_units& obj) {
+      os <<   obj.m_ns/1000000000 << "s, "
+         << ( obj.m_ns%1000000000)/1000000 << " ms, "
+         << ((obj.m_ns%1000000000)%1000000)/1000 << " us, "
+         << ((obj.m_ns%1000000000)%1000000)%1000 << " ns";
+      return os;
+   }
+};
+/*
+   micro-benchmark harness on top of the TSC (fenced reads, converted to ns by tsc_clock)
+   with nanos() as fallback when the TSC is not invariant
+   - payloads are registered by name, each gets n_warmup untimed runs followed by n_reps timed runs
+   - an optional setup function runs before every repetition and is not timed
+     (e.g. to restore the input of an in-place sort or shuffle)
+   - samples above the upper Tukey fence (Q3 + 1.5*IQR) are dropped as outliers:
+     interrupts, page faults and preemption only ever add time, they never remove it
+   - min/median/p99/stddev are reported in the ns_split_in_units format
+
+   note: timings of the -O0 build are mostly noise, use 'make book_1_O2' for numbers worth keeping
+*/
+// keep the compiler from optimizing away a payload's result (GCC/clang)
+template <typename T>
+inline void do_not_optimize(const T& val) {
+   __asm__ __volatile__("" : : "r,m"(val) : "memory");
+}
+struct bench_stats {
+   size_t n_samples = 0;      // samples left after dropping outliers
+   size_t n_dropped = 0;      // outliers
+   long min = 0;
+   long median = 0;
+   long p99 = 0;
+   long max = 0;
+   double mean = 0.0;
+   double stddev = 0.0;
+   uint64_t ticks_median = 0;  // TSC ticks
+};
+// nearest-rank percentile of sorted samples, p in [0,1]
+template <typename T>
+T percentile_sorted(const std::vector<T>& sorted, double p) {
+   if (sorted.empty()) return T();
+   size_t rank = (size_t) std::ceil(p*sorted.size());
+   return sorted[rank==0 ? 0 : rank-1];
+}
+// note: sorts samples_ns in place
+bench_stats compute_bench_stats(std::vector<long>& samples_ns, bool drop_outliers=true)
+{
+   bench_stats st;
+   if (samples_ns.empty()) return st;
+   std::sort(samples_ns.begin(), samples_ns.end());
+   if (drop_outliers && samples_ns.size() >= 4) {
+      const double q1 = percentile_sorted(samples_ns, 0.25);
+      const double q3 = percentile_sorted(samples_ns, 0.75);
+      const double upper_fence = q3 + 1.5*(q3-q1);
+      auto first_outlier = std::upper_bound(samples_ns.begin(), samples_ns.end(), (long) upper_fence);
+      st.n_dropped = std::distance(first_outlier, samples_ns.end());
+      samples_ns.erase(first_outlier, samples_ns.end());
+   }
+   st.n_samples = samples_ns.size();
+   st.min    = samples_ns.front();
+   st.max    = samples_ns.back();
+   st.median = percentile_sorted(samples_ns, 0.50);
+   st.p99    = percentile_sorted(samples_ns, 0.99);
+   double sum = 0.0;
+   for (const auto& e : samples_ns) { sum += e; }
+   st.mean = sum/st.n_samples;
+   double sq_sum = 0.0;
+   for (const auto& e : samples_ns) { sq_sum += (e-st.mean)*(e-st.mean); }
+   st.stddev = st.n_samples > 1 ? std::sqrt(sq_sum/(st.n_samples-1)) : 0.0;
+   return st;
+}
+class bench_harness {
+public:
+   explicit bench_harness(int n_warmup=3, int n_reps=30)
+      : m_n_warmup(n_warmup), m_n_reps(n_reps) {}
+
+   // ops_per_rep: number of operations done by one call of payload, used to additionally report time per op
+   void add(const std::string& name, std::function<void()> payload, long ops_per_rep=1) {
+      m_entries.push_back({name, nullptr, std::move(payload), ops_per_rep});
+   }
+   void add(const std::string& name, std::function<void()> setup, std::function<void()> payload, long ops_per_rep=1) {
+      m_entries.push_back({name, std::move(setup), std::move(payload), ops_per_rep});
+   }
+
+   // measure a single payload without registering it
+   bench_stats measure(const std::function<void()>& payload, const std::function<void()>& setup=nullptr) const {
+      for (int i=0; i<m_n_warmup; ++i) {
+         if (setup) setup();
+         payload();
+      }
+      const bool use_tsc = tsc_clock::invariant(); // also makes sure calibration isn't done in a timed section
+      std::vector<long> samples_ns;
+      std::vector<uint64_t> samples_ticks;
+      samples_ns.reserve(m_n_reps);
+      samples_ticks.reserve(m_n_reps);
+      for (int i=0; i<m_n_reps; ++i) {
+         if (setup) setup();
+         if (use_tsc) {
+            uint64_t rdtsc1 = rdtsc_begin();
+            payload();
+            uint64_t rdtsc2 = rdtsc_end();
+            samples_ns.push_back(tsc_clock::ticks_to_ns(rdtsc2-rdtsc1));
+            samples_ticks.push_back(rdtsc2-rdtsc1);
+         } else {
+            long n1 = nanos();
+            uint64_t rdtsc1 = rdtsc_begin();
+            payload();
+            uint64_t rdtsc2 = rdtsc_end();
+            long n2 = nanos();
+            samples_ns.push_back(n2-n1);
+            samples_ticks.push_back(rdtsc2-rdtsc1);
+         }
+      }
+      bench_stats st = compute_bench_stats(samples_ns);
+      std::sort(samples_ticks.begin(), samples_ticks.end());
+      st.ticks_median = percentile_sorted(samples_ticks, 0.50);
+      return st;
+   }
+
+   int n_warmup() const { return m_n_warmup; }
+   int n_reps() const { return m_n_reps; }
+
+   void run_all(std::ostream& os=cout) const {
+      for (const auto& e : m_entries) {
+         print_stats(os, e.name, measure(e.payload, e.setup), e.ops_per_rep);
+      }
+   }
+
+   static void print_stats(std::ostream& os, const std::string& name, const bench_stats& st, long ops_per_rep=1) {
+      os << "bench '" << name << "': " << st.n_samples << " reps"
+         << " (" << st.n_dropped << " outliers dropped)";
+      if (ops_per_rep > 1) os << ", " << ops_per_rep << " ops/rep";
+      os << "\n";
+      os << "  min     : " << ns_split_in_units(st.min)    << "\n";
+      os << "  median  : " << ns_split_in_units(st.median) << "\n";
+      os << "  p99     : " << ns_split_in_units(st.p99)    << "\n";
+      os << "  stddev  : " << st.stddev << " ns\n";
+      if (ops_per_rep > 1) {
+         os << "  med/op  : " << (double) st.median/ops_per_rep << " ns\n";
+      }
+      os << "  tsc     : " << st.ticks_median << " ticks (median)\n";
+   }
+
+private:
+   struct entry {
+      std::string name;
+      std::function<void()> setup;
+      std::function<void()> payload;
+      long ops_per_rep;
+   };
+   int m_n_warmup;
+   int m_n_reps;
+   std::vector<entry> m_entries;
+};
+
+/*
+   precise wait until a deadline on the nanos() timescale (hybrid sleep/spin)
+   - sleep with clock_nanosleep(TIMER_ABSTIME) until spin_ns before the deadline:
+     no syscall per iteration as with the usleep() loop, and absolute deadlines don't accumulate drift
+   - spin the rest of the time on the calibrated TSC, with pause to be nice to the sibling hyperthread;
+     without an invariant TSC (tsc_clock::invariant(), cached) the ticks aren't time => poll nanos() instead
+   spin_ns has to cover the scheduler's wakeup latency, otherwise the sleep itself overshoots the deadline
+
+   note: clock_nanosleep() doesn't support CLOCK_MONOTONIC_RAW, so the deadline is translated to
+         CLOCK_MONOTONIC -- NTP may slew that by up to 500ppm, hence the extra margin of remaining/1000
+*/
+inline void cpu_relax() {
+   __asm__ __volatile__("pause" : : : "memory");
+}
+void sleep_until_ns(long deadline_ns, long spin_ns = 200000)
+{
+   const bool use_tsc = tsc_clock::invariant();   // calibrates on first use, so before 'remaining' is taken
+   long remaining = deadline_ns - nanos();
+   while (remaining > spin_ns) {
+      struct timespec now_mono;
+      clock_gettime(CLOCK_MONOTONIC, &now_mono);
+      long wakeup_mono = now_mono.tv_sec*1000000000L + now_mono.tv_nsec + remaining - spin_ns - remaining/1000;
+      struct timespec ts = { wakeup_mono/1000000000L, wakeup_mono%1000000000L };
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+      remaining = deadline_ns - nanos();
+   }
+   if (remaining <= 0) {
+      return;
+   }
+   if (!use_tsc) {
+      while (nanos() < deadline_ns) {
+         cpu_relax();
+      }
+      return;
+   }
+   const uint64_t deadline_ticks = rdtsc() + tsc_clock::ns_to_ticks(remaining);
+   while (rdtsc() < deadline_ticks) {
+      cpu_relax();
+   }
+}
+void sleep_for_ns(long ns, long spin_ns = 200000)
+{
+   sleep_until_ns(nanos()+ns, spin_ns);
+}
 void testing_timing()
 {
    cout << "testing nanos:\n";
    cout << "before:\n";
    long n1 = nanos();
-   uint64_t rdtsc1 = rdtsc();
+   uint64_t rdtsc1 = rdtsc_begin();
    
    // payload
    #if 0
@@ -2220,7 +2518,7 @@ void testing_timing()
    }
    #endif
    
-   uint64_t rdtsc2 = rdtsc();
+   uint64_t rdtsc2 = rdtsc_end();
    long n2 = nanos();
    long diff = n2-n1;
    uint64_t diff_rdtsc = rdtsc2-rdtsc1;
@@ -2229,30 +2527,95 @@ void testing_timing()
    cout << "diff       : " << diff << " ns -- i.e.: " << diff/1000000000 << "s and " << diff%1000000000 << " ns\n";
    cout << "rdtsc1     : " << rdtsc1 << "\n";
    cout << "rdtsc2     : " << rdtsc2 << "\n";
-   cout << "diff_rdtsc : " << diff_rdtsc << " ns\n";
+   cout << "diff_rdtsc : " << diff_rdtsc << " ticks -- i.e.: " << tsc_clock::ticks_to_ns(diff_rdtsc) << " ns\n";
+   cout << "tsc        : " << tsc_clock::ticks_per_ns() << " GHz, invariant: " << tsc_clock::invariant() << "\n";
+
+   {
+      // overhead per clock read, averaged over many calls
+      const long N_calls = 1000000;
+      long sink = 0;
+      long t0 = nanos();
+      for (long i=0; i<N_calls; ++i) { sink += nanos(); }
+      long t1 = nanos();
+      for (long i=0; i<N_calls; ++i) { sink += rdtsc_begin(); }
+      long t2 = nanos();
+      for (long i=0; i<N_calls; ++i) { sink += rdtsc_end(); }
+      long t3 = nanos();
+      for (long i=0; i<N_calls; ++i) { sink += tsc_clock::now_ns(); }
+      long t4 = nanos();
+      do_not_optimize(sink);
+      cout << "overhead of nanos()             : " << (double) (t1-t0)/N_calls << " ns\n";
+      cout << "overhead of rdtsc_begin()       : " << (double) (t2-t1)/N_calls << " ns\n";
+      cout << "overhead of rdtsc_end()         : " << (double) (t3-t2)/N_calls << " ns\n";
+      cout << "overhead of tsc_clock::now_ns() : " << (double) (t4-t3)/N_calls << " ns\n";
+      cout << "drift of tsc_clock vs. nanos()  : " << tsc_clock::now_ns()-nanos() << " ns\n";
+   }
 
    long seconds2Wait = 2;
    cout << "waiting for " << seconds2Wait << " seconds:\n" << std::flush;
    long start = nanos();
-   while ( (nanos()-start) < (seconds2Wait*1000000000L) ) {
-      usleep(1);
-   }
+   sleep_until_ns(start + seconds2Wait*1000000000L);
    n2 = nanos();
    cout << "waited for " << n2-start << " ns\n";
    cout << "CLOCKS_PER_SEC: " << CLOCKS_PER_SEC << "\n";
-}
 
-struct ns_split_in_units {
-   long m_ns;
-   explicit ns_split_in_units(long ns) : m_ns(ns) {}
-   friend std::ostream& operator<<(std::ostream& os, const ns_split_in_units& obj) {
-      os <<   obj.m_ns/1000000000 << "s, "
-         << ( obj.m_ns%1000000000)/1000000 << " ms, "
-         << ((obj.m_ns%1000000000)%1000000)/1000 << " us, "
-         << ((obj.m_ns%1000000000)%1000000)%1000 << " ns";
-      return os;
+   {
+      // overshoot (time of return - deadline) of waits of 1 ms,
+      // for the old usleep() loop, a plain clock_nanosleep() and the hybrid sleep/spin
+      const long wait_ns = 1000000;
+      const int N_waits = 300;
+      auto wait_usleep_loop = [](long deadline_ns) {
+         while (nanos() < deadline_ns) {
+            usleep(1);
+         }
+      };
+      auto wait_clock_nanosleep = [](long deadline_ns) {
+         sleep_until_ns(deadline_ns, 0);
+      };
+      auto wait_hybrid = [](long deadline_ns) {
+         sleep_until_ns(deadline_ns);
+      };
+      auto print_overshoot = [&](const std::string& name, auto wait) {
+         std::vector<long> overshoot_ns;
+         overshoot_ns.reserve(N_waits);
+         for (int i=0; i<N_waits; ++i) {
+            const long deadline = nanos() + wait_ns;
+            wait(deadline);
+            overshoot_ns.push_back(nanos()-deadline);
+         }
+         bench_stats st = compute_bench_stats(overshoot_ns, false);
+         cout << "overshoot " << std::setw(16) << std::left << name << std::right
+              << " min: " << std::setw(7) << st.min    << " ns,"
+              << " median: " << std::setw(7) << st.median << " ns,"
+              << " p99: " << std::setw(7) << st.p99    << " ns,"
+              << " max: " << std::setw(7) << st.max    << " ns\n";
+      };
+      cout << N_waits << " waits of " << wait_ns << " ns each:\n";
+      print_overshoot("usleep loop", wait_usleep_loop);
+      print_overshoot("clock_nanosleep", wait_clock_nanosleep);
+      print_overshoot("sleep + spin", wait_hybrid);
    }
-};
+}
+
+void testing_bench_harness()
+{
+   bench_harness bench;
+   // overhead of the harness itself
+   bench.add("empty payload", []{});
+   // the payload that is #if 0'd out in testing_timing() (with 2000 instead of 20000 iterations)
+   bench.add("vector<string> v(i) for i in [0,2000)", []{
+      for (size_t i=0; i < 2000LL; ++i) {
+         std::vector<std::string> v(i);
+         do_not_optimize(v.data());
+      }
+   }, 2000);
+   std::vector<int> v(100000);
+   bench.add("sort 100000 ints",
+      [&v]{ for (size_t i=0; i<v.size(); ++i) { v[i] = rand(); } },  // setup, not timed
+      [&v]{ std::sort(v.begin(), v.end()); },
+      v.size());
+   bench.run_all();
+}
 void testing_vector_capacity()
 {
    /*auto print_ns_split_in_units = [](long ns) {
@@ -2403,6 +2766,363 @@ void testing_vector_capacity()
    }
 }
 
+// for 'testing_vector_capacity_bench' and 'testing_default_init_allocator'
+/*
+   allocator adaptor whose construct() without arguments default-initializes instead of value-initializing,
+   i.e. 'std::vector<int, default_init_allocator<int>> v(N);' and 'v.resize(N);' leave the new ints uninitialized
+   - for types with a non-trivial default ctor, default- and value-initialization are the same thing
+   - everything else (allocate, deallocate, construct with args, ...) goes to the upstream allocator A
+   only makes sense for buffers that are overwritten right away -- reading an element before writing it is UB
+*/
+template <typename T, typename A = std::allocator<T>>
+class default_init_allocator : public A {
+   using a_traits = std::allocator_traits<A>;
+public:
+   template <typename U> struct rebind {
+      using other = default_init_allocator<U, typename a_traits::template rebind_alloc<U>>;
+   };
+   using A::A;
+   default_init_allocator() = default;
+   default_init_allocator(const A& a) noexcept : A(a) {}
+
+   template <typename U>
+   void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+      ::new(static_cast<void*>(p)) U;
+   }
+   template <typename U, typename... Args>
+   void construct(U* p, Args&&... args) {
+      a_traits::construct(static_cast<A&>(*this), p, std::forward<Args>(args)...);
+   }
+};
+// same as the move-demo struct X in main(): owns a heap buffer, so copies are deep -- but doesn't print
+struct X_bench {
+   X_bench() : X_bench(16) {}
+   explicit X_bench(int n) : m_bytes(n), m_data(new char[n]) {}
+   ~X_bench() { delete[] m_data; }
+   X_bench(const X_bench& other) : m_bytes(other.m_bytes), m_data(new char[other.m_bytes]) {
+      memcpy(m_data, other.m_data, other.m_bytes);
+   }
+   X_bench(X_bench&& other) noexcept : m_bytes(other.m_bytes), m_data(other.m_data) {
+      other.m_data = nullptr;
+   }
+   X_bench& operator=(const X_bench& other) {
+      if (this != &other) {
+         char* data = new char[other.m_bytes];
+         memcpy(data, other.m_data, other.m_bytes);
+         delete[] m_data;
+         m_bytes = other.m_bytes;
+         m_data = data;
+      }
+      return *this;
+   }
+   X_bench& operator=(X_bench&& other) noexcept {
+      std::swap(m_bytes, other.m_bytes);
+      std::swap(m_data, other.m_data);
+      return *this;
+   }
+   int m_bytes;
+   char* m_data;
+};
+template <typename T> T make_bench_value(size_t i);
+template <> int make_bench_value<int>(size_t i) { return (int) i; }
+template <> std::string make_bench_value<std::string>(size_t) { return "ingest record"; } // fits into SSO buffer
+template <> X_bench make_bench_value<X_bench>(size_t) { return X_bench(16); }
+
+long minor_page_faults() {
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+   return usage.ru_minflt;
+}
+// one CSV row per (strategy, n_elements), all vectors are filled with make_bench_value<T>(i)
+// bytes_per_elem: approx. memory per element incl. heap memory it owns -- sizes above 1 GiB are skipped
+template <typename T>
+void bench_vector_fill_strategies(const std::string& type_name, size_t bytes_per_elem, std::ostream& os)
+{
+   const size_t max_bytes = 1UL << 30;
+   for (size_t n = 100; n <= 100000000; n *= 10) {
+      if (n*bytes_per_elem > max_bytes) {
+         os << "# " << type_name << "," << n << ": skipped, needs more than " << max_bytes << " bytes\n";
+         continue;
+      }
+      bench_harness bench(1, n >= 10000000 ? 3 : 10);
+      auto run = [&](const std::string& strategy, const std::function<void()>& payload) {
+         long faults_before = minor_page_faults();
+         bench_stats st = bench.measure(payload);
+         long faults = minor_page_faults() - faults_before;
+         os << type_name << "," << strategy << "," << n << ","
+            << st.median << "," << (double) st.median/n << ","
+            << (double) faults/(bench.n_warmup()+bench.n_reps()) << "\n" << std::flush;
+      };
+      run("value-init ctor", [n]{
+         std::vector<T> v(n);
+         for (size_t i=0; i<n; ++i) { v[i] = make_bench_value<T>(i); }
+         do_not_optimize(v.data());
+      });
+      run("reserve+push_back", [n]{
+         std::vector<T> v;
+         v.reserve(n);
+         for (size_t i=0; i<n; ++i) { v.push_back(make_bench_value<T>(i)); }
+         do_not_optimize(v.data());
+      });
+      run("resize+assign", [n]{
+         std::vector<T> v;
+         v.resize(n);
+         for (size_t i=0; i<n; ++i) { v[i] = make_bench_value<T>(i); }
+         do_not_optimize(v.data());
+      });
+      run("emplace_back (no reserve)", [n]{
+         std::vector<T> v;
+         for (size_t i=0; i<n; ++i) { v.emplace_back(make_bench_value<T>(i)); }
+         do_not_optimize(v.data());
+      });
+      run("default-init allocator", [n]{
+         std::vector<T, default_init_allocator<T>> v(n);
+         for (size_t i=0; i<n; ++i) { v[i] = make_bench_value<T>(i); }
+         do_not_optimize(v.data());
+      });
+   }
+}
+/*
+   benchmark matrix for filling a vector with N elements:
+      element types: int, std::string, X_bench (owns heap memory, like struct X in main())
+      sizes:         1e2 ... 1e8
+      strategies:    value-init ctor, reserve+push_back, resize+assign, emplace_back, default-init allocator
+   output is CSV (median of the repetitions), redirect cout to keep it
+*/
+void testing_vector_capacity_bench()
+{
+   cout << "type,strategy,n_elements,median_ns,ns_per_element,minor_faults_per_run\n";
+   bench_vector_fill_strategies<int>("int", sizeof(int), cout);
+   bench_vector_fill_strategies<std::string>("std::string", sizeof(std::string), cout);
+   bench_vector_fill_strategies<X_bench>("X_bench", sizeof(X_bench)+32, cout);
+}
+// std::vector<int> v(N) vs. std::vector<int, default_init_allocator<int>> v(N), for a 100M-element scratch buffer
+void testing_default_init_allocator()
+{
+   const size_t N = 100000000;
+   bench_harness bench(1, 5);
+   auto run = [&bench](const std::string& name, const std::function<void()>& payload) {
+      long faults_before = minor_page_faults();
+      bench_stats st = bench.measure(payload);
+      long faults = minor_page_faults() - faults_before;
+      bench_harness::print_stats(cout, name, st, N);
+      cout << "  faults  : " << faults/(bench.n_warmup()+bench.n_reps()) << " minor page faults/run\n";
+   };
+   // note: without the zero-fill, the pages aren't touched (=> faulted in) until they are written,
+   //       so construction alone looks better than it is -- what counts is construction + overwrite
+   run("vector<int> v(N)", []{
+      std::vector<int> v(N);
+      do_not_optimize(v.data());
+   });
+   run("vector<int,default_init_allocator> v(N)", []{
+      std::vector<int, default_init_allocator<int>> v(N);
+      do_not_optimize(v.data());
+   });
+   run("vector<int> v(N) + overwrite", []{
+      std::vector<int> v(N);
+      for (size_t i=0; i<N; ++i) { v[i] = (int) i; }
+      do_not_optimize(v.data());
+   });
+   run("vector<int,default_init_allocator> v(N) + overwrite", []{
+      std::vector<int, default_init_allocator<int>> v(N);
+      for (size_t i=0; i<N; ++i) { v[i] = (int) i; }
+      do_not_optimize(v.data());
+   });
+   run("vector<int> v; v.resize(N) + overwrite", []{
+      std::vector<int> v;
+      v.resize(N);
+      for (size_t i=0; i<N; ++i) { v[i] = (int) i; }
+      do_not_optimize(v.data());
+   });
+   run("vector<int,default_init_allocator> v; v.resize(N) + overwrite", []{
+      std::vector<int, default_init_allocator<int>> v;
+      v.resize(N);
+      for (size_t i=0; i<N; ++i) { v[i] = (int) i; }
+      do_not_optimize(v.data());
+   });
+   /*
+      => the zero-fill of v(N) is a full extra pass over the buffer (and faults in all its pages up front),
+         with default_init_allocator the only pass is the overwrite
+   */
+}
+
+// for 'testing_hugepage_allocator'
+/*
+   huge-page-backed arena for large allocations
+   - allocations of at least min_bytes get their own mmap region, 2 MiB-aligned and rounded up to 2 MiB,
+     with madvise(MADV_HUGEPAGE) to get it backed by transparent huge pages (THP mode 'madvise' or 'always',
+     see /sys/kernel/mm/transparent_hugepage/enabled)
+   - with populate, regions are pre-faulted when they are allocated instead of on first touch
+   - smaller allocations go to operator new
+   one 2 MiB page needs 1 TLB entry instead of 512, so random access over GiBs of memory does far fewer page walks
+
+   note: MAP_POPULATE at mmap() time would fault the region in before madvise(MADV_HUGEPAGE) is applied,
+         i.e. with 4 KiB pages in THP mode 'madvise' -- so pre-faulting is done after madvise,
+         with MADV_POPULATE_WRITE (Linux 5.14) or by touching every page
+*/
+class hugepage_arena {
+public:
+   static constexpr size_t huge_page_size = 2UL << 20;
+
+   explicit hugepage_arena(bool populate=false, size_t min_bytes=huge_page_size)
+      : m_populate(populate), m_min_bytes(min_bytes) {}
+   hugepage_arena(const hugepage_arena&) = delete;
+   hugepage_arena& operator=(const hugepage_arena&) = delete;
+
+   void* allocate(size_t bytes) {
+      if (bytes < m_min_bytes) {
+         return ::operator new(bytes);
+      }
+      const size_t region_bytes = round_up(bytes);
+      // over-allocate by one huge page and trim, so the region starts at a 2 MiB boundary
+      const size_t mapped_bytes = region_bytes + huge_page_size;
+      void* p = mmap(nullptr, mapped_bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED) {
+         throw std::bad_alloc();
+      }
+      char* raw = static_cast<char*>(p);
+      char* region = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw)));
+      if (region != raw) {
+         munmap(raw, region-raw);
+      }
+      munmap(region+region_bytes, (raw+mapped_bytes) - (region+region_bytes));
+      madvise(region, region_bytes, MADV_HUGEPAGE);
+      if (m_populate) {
+         prefault(region, region_bytes);
+      }
+      m_bytes_mapped += region_bytes;
+      ++m_n_regions;
+      return region;
+   }
+   void deallocate(void* p, size_t bytes) {
+      if (bytes < m_min_bytes) {
+         ::operator delete(p);
+         return;
+      }
+      munmap(p, round_up(bytes));
+      m_bytes_mapped -= round_up(bytes);
+      --m_n_regions;
+   }
+
+   size_t bytes_mapped() const { return m_bytes_mapped; }
+   size_t n_regions() const { return m_n_regions; }
+
+private:
+   static size_t round_up(size_t bytes) {
+      return (bytes + huge_page_size-1) & ~(huge_page_size-1);
+   }
+   static void prefault(char* region, size_t bytes) {
+      #ifdef MADV_POPULATE_WRITE
+      if (madvise(region, bytes, MADV_POPULATE_WRITE) == 0) {
+         return;
+      }
+      #endif
+      for (size_t offset = 0; offset < bytes; offset += 4096) {
+         region[offset] = 0;
+      }
+   }
+
+   bool m_populate;
+   size_t m_min_bytes;
+   std::atomic<size_t> m_bytes_mapped{0};
+   std::atomic<size_t> m_n_regions{0};
+};
+// stateful allocator handing out memory of a hugepage_arena, which has to outlive all containers using it
+template <typename T>
+class hugepage_allocator {
+public:
+   using value_type = T;
+
+   explicit hugepage_allocator(hugepage_arena* arena) noexcept : m_arena(arena) {}
+   template <typename U>
+   hugepage_allocator(const hugepage_allocator<U>& other) noexcept : m_arena(other.arena()) {}
+
+   T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n*sizeof(T))); }
+   void deallocate(T* p, size_t n) noexcept { m_arena->deallocate(p, n*sizeof(T)); }
+
+   hugepage_arena* arena() const noexcept { return m_arena; }
+
+private:
+   hugepage_arena* m_arena;
+};
+template <typename T, typename U>
+bool operator==(const hugepage_allocator<T>& a1, const hugepage_allocator<U>& a2) { return a1.arena() == a2.arena(); }
+template <typename T, typename U>
+bool operator!=(const hugepage_allocator<T>& a1, const hugepage_allocator<U>& a2) { return !(a1 == a2); }
+
+// value of a 'key: value' line in a /proc or /sys file, e.g. 'AnonHugePages' in /proc/self/smaps_rollup
+std::string read_proc_field(const std::string& file_name, const std::string& key)
+{
+   std::ifstream file(file_name);
+   std::string line;
+   while (getline(file, line)) {
+      if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+         auto begIdx = line.find_first_not_of(' ', key.size()+1);
+         return begIdx == std::string::npos ? "" : line.substr(begIdx);
+      }
+   }
+   return "";
+}
+/*
+   TLB-miss-sensitive benchmark: random-index reads over a 1 GiB std::vector<int>,
+   with the default allocator vs. hugepage_arena (pre-faulted and not)
+*/
+void testing_hugepage_allocator()
+{
+   const size_t N = (1UL << 30)/sizeof(int);
+   const long N_reads = 20000000;
+   {
+      std::ifstream thp("/sys/kernel/mm/transparent_hugepage/enabled");
+      std::string thp_mode;
+      getline(thp, thp_mode);
+      cout << "THP mode: " << thp_mode << "\n";
+   }
+   // indices from a 64-bit LCG, top bits used as index in [0,N) (N is a power of 2)
+   auto random_reads = [](const int* data, size_t n, long n_reads) {
+      uint64_t x = 42;
+      const int shift = 64 - __builtin_ctzll(n);
+      long sum = 0;
+      for (long i=0; i<n_reads; ++i) {
+         x = x*6364136223846793005ULL + 1442695040888963407ULL;
+         sum += data[x >> shift];
+      }
+      do_not_optimize(sum);
+   };
+   auto run = [&](const std::string& name, auto& v) {
+      long faults_before = minor_page_faults();
+      long n1 = nanos();
+      for (size_t i=0; i<N; ++i) { v[i] = (int) i; }
+      long n2 = nanos();
+      cout << name << ":\n";
+      cout << "  fill          : " << ns_split_in_units(n2-n1) << ", "
+           << minor_page_faults()-faults_before << " minor page faults\n";
+      cout << "  AnonHugePages : " << read_proc_field("/proc/self/smaps_rollup", "AnonHugePages") << "\n";
+      bench_harness bench(1, 5);
+      bench_harness::print_stats(cout, "random reads", bench.measure([&]{ random_reads(v.data(), N, N_reads); }), N_reads);
+   };
+   // all vectors use default_init_allocator, so the pages are faulted in by the fill and not by the ctor
+   {
+      std::vector<int, default_init_allocator<int>> v(N);
+      run("std::vector<int> (default allocator)", v);
+   }
+   {
+      hugepage_arena arena;
+      long faults_before = minor_page_faults();
+      std::vector<int, default_init_allocator<int, hugepage_allocator<int>>> v(N, hugepage_allocator<int>(&arena));
+      cout << "(hugepage arena: " << arena.n_regions() << " region(s), " << arena.bytes_mapped() << " bytes mapped, "
+           << minor_page_faults()-faults_before << " minor page faults while allocating)\n";
+      run("std::vector<int> (hugepage_arena)", v);
+   }
+   {
+      hugepage_arena arena(true);
+      long faults_before = minor_page_faults();
+      std::vector<int, default_init_allocator<int, hugepage_allocator<int>>> v(N, hugepage_allocator<int>(&arena));
+      cout << "(hugepage arena: " << arena.n_regions() << " region(s), " << arena.bytes_mapped() << " bytes mapped, "
+           << minor_page_faults()-faults_before << " minor page faults while allocating)\n";
+      run("std::vector<int> (hugepage_arena, pre-faulted)", v);
+   }
+}
+
 void test_operator_precedence()
 {
    const char *str = "own strcpy";
@@ -2900,6 +3620,33 @@ struct Customer {
 };
 // own equivalence criterion (p.366: otherwise can't have 'std::unordered_map<Customer, std::string, CustomerHash_better> customer_map;')
 bool operator==(const Customer& c1, const Customer& c2) { return c1.no == c2.no; }
+/*
+   heterogeneous lookup (p.366 requires constructing a full Customer, i.e. 2 std::strings, just to call find())
+   - CustomerKey: non-owning view of the fields a lookup needs, no allocation
+   - hasher and equality have to be transparent ('is_transparent') and agree: hash(CustomerKey) == hash(Customer)
+   - lookup by 'no' alone needs a hasher that only hashes 'no' (CustomerHash_no), as CustomerHash_better
+     also hashes the names
+   - std::unordered_map gets heterogeneous find() only with C++20 => flat_hash_map
+*/
+struct CustomerKey {
+   std::string_view first_name;
+   std::string_view last_name;
+   long no;
+};
+bool operator==(const Customer& c, const CustomerKey& k) { return c.no == k.no; }
+bool operator==(const CustomerKey& k, const Customer& c) { return c.no == k.no; }
+struct CustomerEqual {
+   using is_transparent = void;
+   bool operator() (const Customer& c1, const Customer& c2) const { return c1 == c2; }
+   bool operator() (const Customer& c, const CustomerKey& k) const { return c == k; }
+   bool operator() (const Customer& c, long no) const { return c.no == no; }
+};
+struct CustomerHash_no {
+   using is_transparent = void;
+   std::size_t operator() (const Customer& c) const { return std::hash<long>()(c.no); }
+   std::size_t operator() (const CustomerKey& k) const { return std::hash<long>()(k.no); }
+   std::size_t operator() (long no) const { return std::hash<long>()(no); }
+};
 // naive hash function
 struct CustomerHash_naive {
    std::size_t operator() (const Customer& c) const {
@@ -2929,9 +3676,87 @@ inline std::size_t hash_val(const Types&... args) {
    return seed;
 }
 struct CustomerHash_better {
+   using is_transparent = void;
    std::size_t operator() (const Customer& c) const {
       return hash_val(c.first_name,c.last_name,c.no);
    }
+   // std::hash<string_view> == std::hash<string> for the same characters => same hash as for the Customer
+   std::size_t operator() (const CustomerKey& k) const {
+      return hash_val(k.first_name,k.last_name,k.no);
+   }
+};
+// fast approach (wyhash-style)
+// - std::hash<long> is the identity on libstdc++ and the boost-style hash_combine only shifts/adds,
+//   so e.g. sequential Customer::no values end up as sequential hash values
+// - wymix: full 64x64->128 bit multiply, folded by xor of the high and low half => every input bit affects every output bit
+__extension__ typedef unsigned __int128 uint128_t;
+constexpr uint64_t wyp0 = 0xa0761d6478bd642fULL;
+constexpr uint64_t wyp1 = 0xe7037ed1a0b428dbULL;
+constexpr uint64_t wyp2 = 0x8ebc6af09c88c6e3ULL;
+inline uint64_t wymix(uint64_t a, uint64_t b) {
+   const uint128_t r = (uint128_t) a * b;
+   return (uint64_t) (r >> 64) ^ (uint64_t) r;
+}
+inline uint64_t wyread64(const char* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint64_t wyread32(const char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+// hashes 16 bytes per iteration, the tail (and short inputs) as 8- or 4-byte words
+inline uint64_t wyhash_bytes(const void* data, size_t len, uint64_t seed) {
+   const char* p = static_cast<const char*>(data);
+   seed ^= wymix(seed ^ wyp0, wyp1);
+   uint64_t a, b;
+   if (len <= 16) {
+      if (len >= 4) {
+         // 2 (possibly overlapping) 4-byte words from each end
+         const size_t offset = (len >> 3) << 2;
+         a = (wyread32(p) << 32) | wyread32(p+offset);
+         b = (wyread32(p+len-4) << 32) | wyread32(p+len-4-offset);
+      } else if (len > 0) {
+         a = ((uint64_t) (unsigned char) p[0] << 16) | ((uint64_t) (unsigned char) p[len>>1] << 8) | (unsigned char) p[len-1];
+         b = 0;
+      } else {
+         a = b = 0;
+      }
+   } else {
+      size_t i = len;
+      for (; i > 16; i -= 16, p += 16) {
+         seed = wymix(wyread64(p) ^ wyp1, wyread64(p+8) ^ seed);
+      }
+      // last 16 bytes (overlapping with the previous block if i < 16)
+      a = wyread64(p+i-16);
+      b = wyread64(p+i-8);
+   }
+   return wymix(wyp1 ^ len, wymix(a ^ wyp1, b ^ seed));
+}
+inline uint64_t wyhash_append(uint64_t seed, std::string_view s) {
+   return wyhash_bytes(s.data(), s.size(), seed);
+}
+inline uint64_t wyhash_append(uint64_t seed, const std::string& s) {
+   return wyhash_bytes(s.data(), s.size(), seed);
+}
+template <typename T>
+inline uint64_t wyhash_append(uint64_t seed, const T& val) {
+   uint64_t v;
+   if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+      v = (uint64_t) val;
+   } else {
+      v = std::hash<T>()(val);
+   }
+   return wymix(v ^ wyp0, seed ^ wyp2);
+}
+template <typename... Types>
+inline std::size_t hash_val_wy(const Types&... args) {
+   uint64_t seed = 0;
+   ((seed = wyhash_append(seed, args)), ...);
+   return seed;
+}
+struct CustomerHash_wyhash {
+   using is_transparent = void;
+   std::size_t operator() (const Customer& c) const {
+      return hash_val_wy(c.first_name,c.last_name,c.no);
+   }
+   std::size_t operator() (const CustomerKey& k) const {
+      return hash_val_wy(k.first_name,k.last_name,k.no);
+   }
 };
 
 // helper for 'printHashTableState'
@@ -3158,32 +3983,1045 @@ void testing_unordered_container_custom_hash()
    }
 }
 
-// for 'testing_container_reference_semantics' (p.388)
-struct Item {
-   std::string name;
-   float price;
-   
-   Item(const std::string& n, float p=0.0)
-      : name(n), price(p) {}
-};
+// for 'testing_flat_hash_map'
+/*
+   open-addressing hash map (SwissTable-style), as cache-friendly alternative to the node-based std::unordered_map
+   - elements are stored in one flat slot array, no node per element => no pointer chasing on lookup
+   - one control byte per slot: empty (0x80), deleted (0xfe) or full (0..127 = lower 7 bits of the hash, "h2")
+   - slots are probed in groups of 16: one SSE2 compare checks the h2 of all 16 slots of a group at once,
+     keys are only compared for slots whose h2 matches
+   - groups are probed quadratically (by triangular numbers, which visits every group for a power of 2 number of groups),
+     the probe stops at the first group that has an empty slot
+   - max load factor is 7/8 (deleted slots count as load, they are only reclaimed by a rehash)
+   the hash is post-mixed (wymix), as the group index and h2 need well distributed bits
+   and e.g. std::hash<long> is the identity
+
+   note: as in most open-addressing maps, elements are moved on rehash, i.e. rehashing invalidates
+         iterators, pointers AND references (unlike std::unordered_map)
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_map {
+   // slots are stored with a non-const key so they can be moved on rehash, but only handed out as value_type
+   using slot_type = std::pair<Key, T>;
+public:
+   using key_type = Key;
+   using mapped_type = T;
+   using value_type = std::pair<const Key, T>;
+   using size_type = size_t;
+   using hasher = Hash;
+   using key_equal = KeyEqual;
+
+   template <bool Const>
+   class iterator_impl {
+   public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = typename flat_hash_map::value_type;
+      using difference_type = std::ptrdiff_t;
+      using reference = typename std::conditional<Const, const value_type&, value_type&>::type;
+      using pointer = typename std::conditional<Const, const value_type*, value_type*>::type;
+
+      iterator_impl() = default;
+      iterator_impl(const flat_hash_map* map, size_t idx) : m_map(map), m_idx(idx) { skip_non_full(); }
+      // iterator -> const_iterator
+      template <bool C = Const, typename = typename std::enable_if<C>::type>
+      iterator_impl(const iterator_impl<false>& other) : m_map(other.m_map), m_idx(other.m_idx) {}
+
+      reference operator*() const { return *operator->(); }
+      pointer operator->() const { return reinterpret_cast<pointer>(&m_map->m_slots[m_idx]); }
+      iterator_impl& operator++() { ++m_idx; skip_non_full(); return *this; }
+      iterator_impl operator++(int) { iterator_impl tmp = *this; ++*this; return tmp; }
+      friend bool operator==(const iterator_impl& it1, const iterator_impl& it2) { return it1.m_idx == it2.m_idx; }
+      friend bool operator!=(const iterator_impl& it1, const iterator_impl& it2) { return it1.m_idx != it2.m_idx; }
+
+   private:
+      friend class flat_hash_map;
+      void skip_non_full() {
+         while (m_idx < m_map->m_capacity && m_map->m_ctrl[m_idx] < 0) { ++m_idx; }
+      }
+      const flat_hash_map* m_map = nullptr;
+      size_t m_idx = 0;
+   };
+   using iterator = iterator_impl<false>;
+   using const_iterator = iterator_impl<true>;
+
+   flat_hash_map() = default;
+   explicit flat_hash_map(size_t n_elements, const Hash& hash = Hash(), const KeyEqual& eq = KeyEqual())
+      : m_hash(hash), m_eq(eq) { reserve(n_elements); }
+   flat_hash_map(std::initializer_list<value_type> l) {
+      reserve(l.size());
+      for (const auto& e : l) { insert(e); }
+   }
+   flat_hash_map(const flat_hash_map& other) : m_hash(other.m_hash), m_eq(other.m_eq) {
+      reserve(other.size());
+      for (const auto& e : other) { insert(e); }
+   }
+   flat_hash_map(flat_hash_map&& other) noexcept { swap(other); }
+   flat_hash_map& operator=(flat_hash_map other) noexcept { swap(other); return *this; }
+   ~flat_hash_map() {
+      destroy_slots();
+      deallocate(m_ctrl, m_slots, m_capacity);
+   }
+   void swap(flat_hash_map& other) noexcept {
+      std::swap(m_ctrl, other.m_ctrl);
+      std::swap(m_slots, other.m_slots);
+      std::swap(m_capacity, other.m_capacity);
+      std::swap(m_size, other.m_size);
+      std::swap(m_growth_left, other.m_growth_left);
+      std::swap(m_n_deleted, other.m_n_deleted);
+      std::swap(m_hash, other.m_hash);
+      std::swap(m_eq, other.m_eq);
+   }
 
-template<typename T>
-void printItems(const std::string& msg, const T& container) {
-   cout << msg << "\n";
-   for (const auto& e : container) {
-      cout << " " << e->name << ": " << e->price << "\n";
+   iterator begin() { return iterator(this, 0); }
+   iterator end() { return iterator(this, m_capacity); }
+   const_iterator begin() const { return const_iterator(this, 0); }
+   const_iterator end() const { return const_iterator(this, m_capacity); }
+
+   bool empty() const { return m_size == 0; }
+   size_t size() const { return m_size; }
+   size_t capacity() const { return m_capacity; }
+   size_t n_deleted() const { return m_n_deleted; }
+   double load_factor() const { return m_capacity ? (double) m_size/m_capacity : 0.0; }
+   static constexpr double max_load_factor() { return 7.0/8; }
+
+   iterator find(const Key& key) {
+      size_t idx = find_index(key, mixed_hash(key));
+      return idx == npos ? end() : iterator(this, idx);
+   }
+   const_iterator find(const Key& key) const {
+      size_t idx = find_index(key, mixed_hash(key));
+      return idx == npos ? end() : const_iterator(this, idx);
+   }
+   size_t count(const Key& key) const { return find_index(key, mixed_hash(key)) == npos ? 0 : 1; }
+   // heterogeneous lookup (as C++20's unordered_map): only if Hash and KeyEqual both define 'is_transparent'
+   template <typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename H::is_transparent, typename = typename E::is_transparent>
+   iterator find(const K& key) {
+      size_t idx = find_index(key, mixed_hash(key));
+      return idx == npos ? end() : iterator(this, idx);
+   }
+   template <typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename H::is_transparent, typename = typename E::is_transparent>
+   const_iterator find(const K& key) const {
+      size_t idx = find_index(key, mixed_hash(key));
+      return idx == npos ? end() : const_iterator(this, idx);
+   }
+   template <typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename H::is_transparent, typename = typename E::is_transparent>
+   size_t count(const K& key) const { return find_index(key, mixed_hash(key)) == npos ? 0 : 1; }
+   T& at(const Key& key) {
+      size_t idx = find_index(key, mixed_hash(key));
+      if (idx == npos) throw std::out_of_range("flat_hash_map::at");
+      return m_slots[idx].second;
+   }
+   T& operator[](const Key& key) { return try_emplace(key).first->second; }
+   T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+   template <typename K, typename... Args>
+   std::pair<iterator,bool> try_emplace(K&& key, Args&&... args) {
+      const size_t h = mixed_hash(key);
+      size_t idx = find_index(key, h);
+      if (idx != npos) {
+         return {iterator(this, idx), false};
+      }
+      idx = prepare_insert(h);
+      new (&m_slots[idx]) slot_type(std::piecewise_construct,
+                                    std::forward_as_tuple(std::forward<K>(key)),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+      set_ctrl(idx, h);
+      return {iterator(this, idx), true};
+   }
+   std::pair<iterator,bool> insert(const value_type& v) { return try_emplace(v.first, v.second); }
+   template <typename... Args>
+   std::pair<iterator,bool> emplace(Args&&... args) {
+      // key has to be constructed to be hashed anyway
+      slot_type s(std::forward<Args>(args)...);
+      return try_emplace(std::move(s.first), std::move(s.second));
    }
-}
-void testing_container_reference_semantics()
-{
-   {
-      typedef std::shared_ptr<Item> ItemPtr;
-      std::set<ItemPtr> allItems;
-      std::deque<ItemPtr> bestsellers;
 
-      bestsellers = {
-         std::make_shared<Item>("Kong Yize",20.10),
-         std::make_shared<Item>("A Midsummer Night's Dream",14.99),
+   size_t erase(const Key& key) {
+      size_t idx = find_index(key, mixed_hash(key));
+      if (idx == npos) {
+         return 0;
+      }
+      erase_at(idx);
+      return 1;
+   }
+   iterator erase(const_iterator pos) {
+      erase_at(pos.m_idx);
+      return iterator(this, pos.m_idx+1);
+   }
+   void clear() {
+      destroy_slots();
+      if (m_capacity) {
+         std::fill(m_ctrl, m_ctrl+m_capacity, k_empty);
+      }
+      m_size = 0;
+      m_n_deleted = 0;
+      m_growth_left = capacity_to_growth(m_capacity);
+   }
+   void reserve(size_t n_elements) {
+      size_t cap = k_group_width;
+      while (capacity_to_growth(cap) < n_elements) { cap *= 2; }
+      if (cap > m_capacity) {
+         rehash(cap);
+      }
+   }
+
+   // introspection (see 'printFlatHashTableState'):
+   // histogram of the number of groups probed beyond the home group to reach each element
+   std::vector<size_t> probe_length_histogram() const {
+      std::vector<size_t> hist;
+      for (size_t idx = 0; idx < m_capacity; ++idx) {
+         if (m_ctrl[idx] < 0) continue;
+         const size_t h = mixed_hash(m_slots[idx].first);
+         const size_t mask = m_capacity/k_group_width - 1;
+         size_t g = (h >> 7) & mask;
+         size_t n_probes = 0;
+         for (size_t i = 1; g != idx/k_group_width; ++i) {
+            g = (g + i) & mask;
+            ++n_probes;
+         }
+         if (hist.size() <= n_probes) hist.resize(n_probes+1);
+         ++hist[n_probes];
+      }
+      return hist;
+   }
+   // control byte of slot idx: -128 empty, -2 deleted, 0..127 full (h2)
+   int8_t ctrl_byte(size_t idx) const { return m_ctrl[idx]; }
+   static constexpr size_t group_width() { return k_group_width; }
+
+private:
+   static constexpr int8_t k_empty = -128;
+   static constexpr int8_t k_deleted = -2;
+   static constexpr size_t k_group_width = 16;
+   static constexpr size_t npos = size_t(-1);
+
+   static size_t capacity_to_growth(size_t cap) { return cap - cap/8; }
+
+   template <typename K>
+   size_t mixed_hash(const K& key) const {
+      return wymix(m_hash(key), 0x9e3779b97f4a7c15ULL);
+   }
+   __m128i load_group(size_t g) const {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_ctrl + g*k_group_width));
+   }
+   template <typename K>
+   size_t find_index(const K& key, size_t h) const {
+      if (m_capacity == 0) {
+         return npos;
+      }
+      const __m128i h2 = _mm_set1_epi8((char) (h & 0x7f));
+      const __m128i empty = _mm_set1_epi8(k_empty);
+      const size_t mask = m_capacity/k_group_width - 1;
+      size_t g = (h >> 7) & mask;
+      for (size_t i = 1; ; ++i) {
+         const __m128i group = load_group(g);
+         unsigned match = _mm_movemask_epi8(_mm_cmpeq_epi8(group, h2));
+         while (match) {
+            const size_t idx = g*k_group_width + __builtin_ctz(match);
+            if (m_eq(m_slots[idx].first, key)) {
+               return idx;
+            }
+            match &= match-1;
+         }
+         if (_mm_movemask_epi8(_mm_cmpeq_epi8(group, empty))) {
+            return npos;
+         }
+         g = (g + i) & mask;
+      }
+   }
+   // first empty or deleted slot in the probe sequence of h (empty and deleted are the only negative control bytes)
+   size_t find_first_non_full(size_t h) const {
+      const size_t mask = m_capacity/k_group_width - 1;
+      size_t g = (h >> 7) & mask;
+      for (size_t i = 1; ; ++i) {
+         const unsigned non_full = _mm_movemask_epi8(load_group(g));
+         if (non_full) {
+            return g*k_group_width + __builtin_ctz(non_full);
+         }
+         g = (g + i) & mask;
+      }
+   }
+   // returns slot to construct a new element with hash h in, rehashes if necessary
+   // (the counters are only updated by set_ctrl(), after the construction didn't throw)
+   size_t prepare_insert(size_t h) {
+      size_t idx = m_capacity ? find_first_non_full(h) : npos;
+      if (idx == npos || (m_growth_left == 0 && m_ctrl[idx] == k_empty)) {
+         // with many deleted slots, rehashing in place is enough to make room
+         rehash(m_capacity == 0 ? k_group_width :
+                m_size+1 <= capacity_to_growth(m_capacity)/2 ? m_capacity : 2*m_capacity);
+         idx = find_first_non_full(h);
+      }
+      return idx;
+   }
+   void set_ctrl(size_t idx, size_t h) {
+      if (m_ctrl[idx] == k_empty) {
+         --m_growth_left;
+      } else {
+         --m_n_deleted;
+      }
+      m_ctrl[idx] = (int8_t) (h & 0x7f);
+      ++m_size;
+   }
+   void erase_at(size_t idx) {
+      m_slots[idx].~slot_type();
+      --m_size;
+      // if the group still has an empty slot, no probe sequence ever went past this group => slot can become empty
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(load_group(idx/k_group_width), _mm_set1_epi8(k_empty)))) {
+         m_ctrl[idx] = k_empty;
+         ++m_growth_left;
+      } else {
+         m_ctrl[idx] = k_deleted;
+         ++m_n_deleted;
+      }
+   }
+   void rehash(size_t new_capacity) {
+      int8_t* old_ctrl = m_ctrl;
+      slot_type* old_slots = m_slots;
+      const size_t old_capacity = m_capacity;
+      m_ctrl = new int8_t[new_capacity];
+      std::fill(m_ctrl, m_ctrl+new_capacity, k_empty);
+      m_slots = std::allocator<slot_type>().allocate(new_capacity);
+      m_capacity = new_capacity;
+      for (size_t idx = 0; idx < old_capacity; ++idx) {
+         if (old_ctrl[idx] < 0) continue;
+         const size_t h = mixed_hash(old_slots[idx].first);
+         const size_t new_idx = find_first_non_full(h);
+         new (&m_slots[new_idx]) slot_type(std::move(old_slots[idx]));
+         old_slots[idx].~slot_type();
+         m_ctrl[new_idx] = (int8_t) (h & 0x7f);
+      }
+      m_n_deleted = 0;
+      m_growth_left = capacity_to_growth(m_capacity) - m_size;
+      deallocate(old_ctrl, old_slots, old_capacity);
+   }
+   void destroy_slots() {
+      for (size_t idx = 0; idx < m_capacity; ++idx) {
+         if (m_ctrl[idx] >= 0) m_slots[idx].~slot_type();
+      }
+   }
+   static void deallocate(int8_t* ctrl, slot_type* slots, size_t capacity) {
+      delete[] ctrl;
+      if (slots) std::allocator<slot_type>().deallocate(slots, capacity);
+   }
+
+   int8_t* m_ctrl = nullptr;
+   slot_type* m_slots = nullptr;
+   size_t m_capacity = 0;     // 0 or a power of 2 >= 16
+   size_t m_size = 0;
+   size_t m_growth_left = 0;  // number of empty slots that may still be filled before a rehash
+   size_t m_n_deleted = 0;
+   Hash m_hash;
+   KeyEqual m_eq;
+};
+// introspection as in 'printHashTableState', control bytes are printed as '.' (empty), 'x' (deleted), '#' (full)
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void printFlatHashTableState(const flat_hash_map<Key,T,Hash,KeyEqual>& cont, bool print_groups = true)
+{
+   cout << "size:            " << cont.size() << "\n";
+   cout << "capacity:        " << cont.capacity() << " (" << cont.capacity()/cont.group_width() << " groups)\n";
+   cout << "load factor:     " << cont.load_factor() << "\n";
+   cout << "max load factor: " << cont.max_load_factor() << "\n";
+   cout << "deleted slots:   " << cont.n_deleted() << "\n";
+   const auto hist = cont.probe_length_histogram();
+   cout << "probe lengths (groups probed beyond home group -> num of elements):\n";
+   for (size_t i = 0; i < hist.size(); ++i) {
+      cout << "  " << std::setw(2) << i << " -> " << hist[i] << "\n";
+   }
+   if (print_groups) {
+      cout << "groups:\n";
+      for (size_t g = 0; g < cont.capacity()/cont.group_width(); ++g) {
+         cout << "  g[" << std::setw(2) << g << "]: ";
+         for (size_t i = 0; i < cont.group_width(); ++i) {
+            const int8_t c = cont.ctrl_byte(g*cont.group_width()+i);
+            cout << (c == -128 ? '.' : c < 0 ? 'x' : '#');
+         }
+         cout << "\n";
+      }
+   }
+}
+// n customers with unique numbers 0..n-1 in random order, names made of random syllables (4 to 10 chars, no heap)
+std::vector<Customer> make_customers(size_t n, unsigned seed = 42)
+{
+   static const char* syllables[] = {
+      "ka", "lo", "mi", "ne", "ru", "sa", "to", "vi", "an", "el", "or", "us", "be", "da", "fi", "go"
+   };
+   std::mt19937 engine(seed);
+   std::uniform_int_distribution<int> dist_syllable(0, std::size(syllables)-1);
+   std::uniform_int_distribution<int> dist_n_syllables(2, 5);
+   auto make_name = [&]() {
+      std::string name;
+      for (int i = dist_n_syllables(engine); i > 0; --i) {
+         name += syllables[dist_syllable(engine)];
+      }
+      name[0] = std::toupper(name[0]);
+      return name;
+   };
+   std::vector<Customer> customers(n);
+   for (size_t i = 0; i < n; ++i) {
+      customers[i] = Customer{make_name(), make_name(), (long) i};
+   }
+   std::shuffle(customers.begin(), customers.end(), engine);
+   return customers;
+}
+void testing_flat_hash_map()
+{
+   {
+      flat_hash_map<Customer, std::string, CustomerHash_better> customer_map;
+      customer_map[{"Max", "Mustermann", 42}] += "> customer added to map\n";
+      customer_map.insert({{"fname1","lname1",11},""});
+      customer_map.emplace(Customer{"fname2","lname2",22}, "");
+      for (long i = 0; i < 20; ++i) {
+         customer_map.try_emplace(Customer{"Bob", "Smith", 100+i}, "order " + std::to_string(i));
+      }
+      customer_map.erase({"Bob", "Smith", 105});
+      cout << "customer_map:\n";
+      for (const auto& [k,v] : customer_map) {
+         cout << "  customer: " << k << " -> '" << v.substr(0, v.find('\n')) << "'\n";
+      }
+      printFlatHashTableState(customer_map);
+   }
+   {
+      // a throwing value constructor leaves size, counters and control bytes as they were
+      // (a constant hash fills whole groups => erased slots become deleted, not empty)
+      struct Thrower { explicit Thrower(bool do_throw) { if (do_throw) throw std::runtime_error("Thrower"); } };
+      struct ConstHash { size_t operator()(long) const { return 0; } };
+      flat_hash_map<long, Thrower, ConstHash> m;
+      for (long i = 0; i < 100; ++i) m.try_emplace(i, false);
+      for (long i = 0; i < 100; i += 3) m.erase(i);
+      const size_t size = m.size(), n_deleted = m.n_deleted();
+      for (long i = 0; i < 100; i += 3) {
+         try { m.try_emplace(i, true); } catch (const std::runtime_error&) {}
+      }
+      auto n_deleted_ctrl = [&m]{
+         size_t n = 0;
+         for (size_t idx = 0; idx < m.capacity(); ++idx) n += m.ctrl_byte(idx) == -2;
+         return n;
+      };
+      cout << "after throwing inserts: size " << size << " -> " << m.size() << ", deleted " << n_deleted << " -> "
+           << m.n_deleted() << " (" << n_deleted_ctrl() << " deleted control bytes)\n";
+      for (long i = 0; i < 100; i += 3) m.try_emplace(i, false);
+      cout << "reinserted: size " << m.size() << ", deleted " << m.n_deleted() << " (" << n_deleted_ctrl()
+           << " deleted control bytes)\n";
+   }
+   cout << "–––\n";
+
+   // insert and look up 10M customers: flat_hash_map vs. std::unordered_map vs. std::unordered_set
+   const size_t N = 10000000;
+   const std::vector<Customer> customers = make_customers(N);
+   std::vector<Customer> lookups(customers.begin(), customers.end());
+   std::shuffle(lookups.begin(), lookups.end(), std::mt19937(7));
+   for (size_t i = 0; i < N; i += 2) {
+      lookups[i].no += N; // every 2nd lookup misses
+   }
+   bench_harness bench(0, 3);
+   auto run = [&](const std::string& name, auto make_container, auto insert, auto contains) {
+      using container_t = decltype(make_container());
+      std::unique_ptr<container_t> cont;
+      bench_stats st_insert = bench.measure(
+         [&]{ for (const auto& c : customers) { insert(*cont, c); } },
+         [&]{ cont.reset(); cont = std::make_unique<container_t>(make_container()); });
+      bench_harness::print_stats(cout, name + ": insert " + std::to_string(N), st_insert, N);
+      size_t n_found = 0;
+      bench_stats st_find = bench.measure(
+         [&]{ for (const auto& c : lookups) { n_found += contains(*cont, c); } });
+      bench_harness::print_stats(cout, name + ": find " + std::to_string(N) + " (50% hits)", st_find, N);
+      cout << "  found   : " << n_found/bench.n_reps() << "\n";
+   };
+   run("std::unordered_map",
+      []{ return std::unordered_map<Customer, long, CustomerHash_better>(); },
+      [](auto& m, const Customer& c){ m.emplace(c, c.no); },
+      [](const auto& m, const Customer& c){ return m.count(c); });
+   run("std::unordered_set",
+      []{ return std::unordered_set<Customer, CustomerHash_better>(); },
+      [](auto& s, const Customer& c){ s.insert(c); },
+      [](const auto& s, const Customer& c){ return s.count(c); });
+   run("flat_hash_map",
+      []{ return flat_hash_map<Customer, long, CustomerHash_better>(); },
+      [](auto& m, const Customer& c){ m.try_emplace(c, c.no); },
+      [](const auto& m, const Customer& c){ return m.count(c); });
+}
+
+// for 'testing_hash_quality'
+/*
+   avalanche test: flipping one input bit should flip each output bit with probability 1/2
+   - input bits: the 64 bits of Customer::no and the 64 bits of the first 8 chars of Customer::last_name
+   - bias of (input bit i, output bit j) is |2*P(j flips when i is flipped) - 1|, 0 is ideal, 1 means j never/always flips
+   returns {max bias, mean bias} over all (i,j)
+*/
+template <typename Hash>
+std::pair<double,double> avalanche_bias(const Hash& hash, size_t n_samples, unsigned seed = 42)
+{
+   const int n_in = 128;
+   const int n_out = 64;
+   std::vector<size_t> n_flips(n_in*n_out, 0);
+   std::mt19937_64 engine(seed);
+   auto random_name = [&engine]() {
+      std::string name(8, ' ');
+      for (auto& c : name) { c = 'a' + engine()%26; }
+      return name;
+   };
+   for (size_t s = 0; s < n_samples; ++s) {
+      const Customer c{random_name(), random_name(), (long) engine()};
+      const uint64_t h = hash(c);
+      for (int i = 0; i < n_in; ++i) {
+         Customer c_flipped = c;
+         if (i < 64) {
+            c_flipped.no ^= 1L << i;
+         } else {
+            c_flipped.last_name[(i-64)/8] ^= (char) (1 << ((i-64)%8));
+         }
+         const uint64_t diff = h ^ (uint64_t) hash(c_flipped);
+         for (int j = 0; j < n_out; ++j) {
+            n_flips[i*n_out+j] += (diff >> j) & 1;
+         }
+      }
+   }
+   double max_bias = 0.0;
+   double sum_bias = 0.0;
+   for (const auto& n : n_flips) {
+      const double bias = std::abs(2.0*n/n_samples - 1.0);
+      max_bias = std::max(max_bias, bias);
+      sum_bias += bias;
+   }
+   return {max_bias, sum_bias/n_flips.size()};
+}
+/*
+   chi-square of the bucket occupancy when putting keys into n_buckets buckets
+   - bucket index is 'hash % n_buckets' (as std::unordered_map does, with a prime number of buckets)
+     or 'hash & (n_buckets-1)' (power of 2 number of buckets, as in most open-addressing tables)
+   returns chi^2/degrees of freedom: ~1 for a random-like distribution, >>1 means clustering,
+   <<1 means more regular than random (harmless for a hash table)
+*/
+template <typename Hash>
+double bucket_chi_square(const Hash& hash, const std::vector<Customer>& keys, size_t n_buckets, bool mask)
+{
+   std::vector<size_t> counts(n_buckets, 0);
+   for (const auto& k : keys) {
+      const size_t h = hash(k);
+      ++counts[mask ? (h & (n_buckets-1)) : (h % n_buckets)];
+   }
+   const double expected = (double) keys.size()/n_buckets;
+   double chi2 = 0.0;
+   for (const auto& n : counts) {
+      chi2 += (n-expected)*(n-expected)/expected;
+   }
+   return chi2/(n_buckets-1);
+}
+void testing_hash_quality()
+{
+   const size_t N = 1000000;
+   const size_t n_buckets_prime = 1048573;   // largest prime < 2^20
+   const size_t n_buckets_pow2 = 1UL << 20;
+   std::vector<Customer> keys_sequential;
+   std::vector<Customer> keys_strided;
+   for (size_t i = 0; i < N; ++i) {
+      keys_sequential.push_back({"Max", "Mustermann", (long) i});
+      keys_strided.push_back({"Max", "Mustermann", (long) i*1024});
+   }
+   const std::vector<Customer> keys_random = make_customers(N);
+
+   auto report = [&](const std::string& name, const auto& hash) {
+      const auto [max_bias, mean_bias] = avalanche_bias(hash, 2000);
+      cout << name << ":\n";
+      cout << "  avalanche bias (max/mean):       " << max_bias << " / " << mean_bias << "\n";
+      cout << "  chi2/df, sequential no (prime):  " << bucket_chi_square(hash, keys_sequential, n_buckets_prime, false) << "\n";
+      cout << "  chi2/df, sequential no (2^20):   " << bucket_chi_square(hash, keys_sequential, n_buckets_pow2, true) << "\n";
+      cout << "  chi2/df, no*1024 (prime):        " << bucket_chi_square(hash, keys_strided, n_buckets_prime, false) << "\n";
+      cout << "  chi2/df, no*1024 (2^20):         " << bucket_chi_square(hash, keys_strided, n_buckets_pow2, true) << "\n";
+      cout << "  chi2/df, random customers (2^20):" << bucket_chi_square(hash, keys_random, n_buckets_pow2, true) << "\n";
+      bench_harness bench(1, 10);
+      bench_harness::print_stats(cout, name + ": hash " + std::to_string(N) + " random customers",
+         bench.measure([&]{
+            size_t sum = 0;
+            for (const auto& k : keys_random) { sum += hash(k); }
+            do_not_optimize(sum);
+         }), N);
+   };
+   report("CustomerHash_naive", CustomerHash_naive());
+   report("CustomerHash_better", CustomerHash_better());
+   report("CustomerHash_wyhash", CustomerHash_wyhash());
+}
+
+// for 'testing_hash_table_stats'
+/*
+   bucket occupancy as numbers instead of printHashTableState's text dump
+   - type-deduced: works for every container with the bucket interface (unordered_[multi]set/map,
+     no UNORDERED_T tag needed, as the elements are never printed) and for flat_hash_map
+   - chain_length_histogram[len] = number of (sampled) buckets holding len elements (index 0: empty buckets)
+   - probe_length_histogram[n] = number of elements found after probing n+1 buckets, only filled for
+     open addressing (flat_hash_map), where a bucket's elements aren't all found in that bucket
+   - probe cost = number of elements compared by a successful find(), averaged over all elements:
+        observed: sum(len*(len+1)/2)/sum(len) over the buckets
+        expected: 1 + load_factor/2 for a hash function that behaves like a random function (Knuth)
+     => observed/expected >> 1 is what to alert on: keys cluster in few buckets, lookups degrade to list walks
+   - cost: bucket_size(idx) walks the bucket (libstdc++), so a full scan is O(size + bucket_count)
+     => to sample periodically pass n_sample_buckets: only every k-th bucket is visited,
+        the ratios are estimates and max_chain_length a lower bound
+   - n_rehashes is only known if the container is wrapped in 'rehash_counted'
+*/
+struct hash_table_stats_t {
+   size_t size = 0;
+   size_t bucket_count = 0;
+   double load_factor = 0.0;
+   double max_load_factor = 0.0;
+   size_t n_buckets_sampled = 0;
+   std::vector<size_t> chain_length_histogram;
+   std::vector<size_t> probe_length_histogram;
+   size_t max_chain_length = 0;
+   double empty_bucket_ratio = 0.0;
+   double expected_probe_cost = 0.0;
+   double observed_probe_cost = 0.0;
+   bool rehash_count_known = false;
+   size_t n_rehashes = 0;
+};
+template <typename Cont>
+hash_table_stats_t hash_table_stats(const Cont& cont, size_t n_sample_buckets = 0)
+{
+   hash_table_stats_t st;
+   st.size = cont.size();
+   st.bucket_count = cont.bucket_count();
+   st.load_factor = cont.load_factor();
+   st.max_load_factor = cont.max_load_factor();
+   const size_t stride = (n_sample_buckets == 0 || n_sample_buckets >= st.bucket_count) ? 1 : st.bucket_count/n_sample_buckets;
+   size_t n_empty = 0;
+   size_t n_elems = 0;
+   size_t n_compares = 0;
+   for (size_t idx = 0; idx < st.bucket_count; idx += stride) {
+      const size_t len = cont.bucket_size(idx);
+      if (st.chain_length_histogram.size() <= len) st.chain_length_histogram.resize(len+1);
+      ++st.chain_length_histogram[len];
+      st.max_chain_length = std::max(st.max_chain_length, len);
+      n_empty += (len == 0);
+      n_elems += len;
+      n_compares += len*(len+1)/2;
+      ++st.n_buckets_sampled;
+   }
+   st.empty_bucket_ratio = st.n_buckets_sampled ? (double) n_empty/st.n_buckets_sampled : 0.0;
+   st.expected_probe_cost = 1.0 + st.load_factor/2;
+   st.observed_probe_cost = n_elems ? (double) n_compares/n_elems : 0.0;
+   return st;
+}
+/*
+   flat_hash_map: a "bucket" is a group of group_width() slots, so chain_length_histogram is the
+   group occupancy (0..group_width()), the probe length of an element is the number of groups probed
+   to find it (probe_length_histogram[0] = found in its home group)
+   - observed_probe_cost is in groups probed, the ideal 1 (every element in its home group) is the expected one
+   - probe_length_histogram() recomputes the hash of every element => always a full O(capacity) scan
+*/
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+hash_table_stats_t hash_table_stats(const flat_hash_map<Key,T,Hash,KeyEqual>& cont, size_t = 0)
+{
+   hash_table_stats_t st;
+   st.size = cont.size();
+   st.bucket_count = cont.capacity()/cont.group_width();
+   st.load_factor = cont.load_factor();
+   st.max_load_factor = cont.max_load_factor();
+   st.n_buckets_sampled = st.bucket_count;
+   st.chain_length_histogram.assign(cont.group_width()+1, 0);
+   for (size_t g = 0; g < st.bucket_count; ++g) {
+      size_t len = 0;
+      for (size_t i = 0; i < cont.group_width(); ++i) {
+         len += cont.ctrl_byte(g*cont.group_width()+i) >= 0;   // full slot
+      }
+      ++st.chain_length_histogram[len];
+      st.max_chain_length = std::max(st.max_chain_length, len);
+   }
+   st.empty_bucket_ratio = st.bucket_count ? (double) st.chain_length_histogram[0]/st.bucket_count : 0.0;
+   st.probe_length_histogram = cont.probe_length_histogram();
+   size_t n_compares = 0;
+   for (size_t n_probes = 0; n_probes < st.probe_length_histogram.size(); ++n_probes) {
+      n_compares += (n_probes+1)*st.probe_length_histogram[n_probes];
+   }
+   st.expected_probe_cost = 1.0;
+   st.observed_probe_cost = st.size ? (double) n_compares/st.size : 0.0;
+   return st;
+}
+/*
+   counts the rehashes of an unordered container: every member that may rehash compares
+   bucket_count() before and after
+   - usage: rehash_counted<std::unordered_map<K,V>> m; ... hash_table_stats(m).n_rehashes
+   - all inserting members are wrapped: insert, emplace, emplace_hint, try_emplace, insert_or_assign,
+     operator[], merge (the map-only ones are templates, only instantiated when used)
+   - erase() never rehashes (p.362), so it is inherited unchanged
+*/
+template <typename Cont>
+class rehash_counted : public Cont {
+public:
+   using Cont::Cont;
+
+   template <typename... Args>
+   decltype(auto) insert(Args&&... args) {
+      return counting([&]() -> decltype(auto) { return Cont::insert(std::forward<Args>(args)...); });
+   }
+   void insert(std::initializer_list<typename Cont::value_type> il) {
+      counting([&]{ Cont::insert(il); });
+   }
+   template <typename... Args>
+   decltype(auto) emplace(Args&&... args) {
+      return counting([&]() -> decltype(auto) { return Cont::emplace(std::forward<Args>(args)...); });
+   }
+   template <typename... Args>
+   decltype(auto) emplace_hint(Args&&... args) {
+      return counting([&]() -> decltype(auto) { return Cont::emplace_hint(std::forward<Args>(args)...); });
+   }
+   template <typename... Args>
+   decltype(auto) try_emplace(Args&&... args) {
+      return counting([&]() -> decltype(auto) { return Cont::try_emplace(std::forward<Args>(args)...); });
+   }
+   template <typename... Args>
+   decltype(auto) insert_or_assign(Args&&... args) {
+      return counting([&]() -> decltype(auto) { return Cont::insert_or_assign(std::forward<Args>(args)...); });
+   }
+   template <typename Source>
+   void merge(Source&& source) {
+      counting([&]{ Cont::merge(std::forward<Source>(source)); });
+   }
+   template <typename K>
+   decltype(auto) operator[](K&& key) {
+      return counting([&]() -> decltype(auto) { return Cont::operator[](std::forward<K>(key)); });
+   }
+   void reserve(size_t n) { counting([&]{ Cont::reserve(n); }); }
+   void rehash(size_t n) { counting([&]{ Cont::rehash(n); }); }
+   void max_load_factor(float ml) { counting([&]{ Cont::max_load_factor(ml); }); }
+   float max_load_factor() const { return Cont::max_load_factor(); }
+
+   size_t n_rehashes() const { return m_n_rehashes; }
+
+private:
+   template <typename Op>
+   decltype(auto) counting(Op op) {
+      const size_t n_buckets = Cont::bucket_count();
+      if constexpr (std::is_void<decltype(op())>::value) {
+         op();
+         m_n_rehashes += (Cont::bucket_count() != n_buckets);
+      } else {
+         decltype(auto) ret = op();
+         m_n_rehashes += (Cont::bucket_count() != n_buckets);
+         return ret;
+      }
+   }
+
+   size_t m_n_rehashes = 0;
+};
+template <typename Cont>
+hash_table_stats_t hash_table_stats(const rehash_counted<Cont>& cont, size_t n_sample_buckets = 0)
+{
+   hash_table_stats_t st = hash_table_stats(static_cast<const Cont&>(cont), n_sample_buckets);
+   st.rehash_count_known = true;
+   st.n_rehashes = cont.n_rehashes();
+   return st;
+}
+void printHashTableStats(const hash_table_stats_t& st)
+{
+   cout << "size: " << st.size << ", buckets: " << st.bucket_count << " (" << st.n_buckets_sampled << " sampled)"
+        << ", load factor: " << st.load_factor << " (max " << st.max_load_factor << ")\n";
+   cout << "  empty buckets: " << 100*st.empty_bucket_ratio << " %, max chain length: " << st.max_chain_length
+        << ", probe cost (expected/observed): " << st.expected_probe_cost << " / " << st.observed_probe_cost;
+   if (st.rehash_count_known) {
+      cout << ", rehashes: " << st.n_rehashes;
+   }
+   cout << "\n  chain length histogram:";
+   for (size_t len = 0; len < st.chain_length_histogram.size(); ++len) {
+      if (st.chain_length_histogram[len]) cout << " " << len << ":" << st.chain_length_histogram[len];
+   }
+   if (!st.probe_length_histogram.empty()) {
+      cout << "\n  groups probed histogram:";
+      for (size_t n = 0; n < st.probe_length_histogram.size(); ++n) {
+         if (st.probe_length_histogram[n]) cout << " " << n+1 << ":" << st.probe_length_histogram[n];
+      }
+   }
+   cout << "\n";
+}
+void testing_hash_table_stats()
+{
+   const size_t N = 1000000;
+   const std::vector<Customer> customers = make_customers(N);
+   {
+      rehash_counted<std::unordered_set<Customer, CustomerHash_better>> customer_set;
+      for (const auto& c : customers) customer_set.insert(c);
+      cout << "unordered_set<Customer, CustomerHash_better>, random customers:\n";
+      printHashTableStats(hash_table_stats(customer_set));
+   }
+   {
+      // sequential numbers with the naive hash: the same names for all => only 'no' varies
+      rehash_counted<std::unordered_set<Customer, CustomerHash_naive>> customer_set;
+      customer_set.reserve(N);
+      for (size_t i = 0; i < N; ++i) customer_set.emplace(Customer{"Max", "Mustermann", (long) i});
+      cout << "unordered_set<Customer, CustomerHash_naive>, same names, sequential no (reserved):\n";
+      printHashTableStats(hash_table_stats(customer_set));
+   }
+   {
+      // degenerate: only multiples of 1024, with a power-of-2 bucket count this would be
+      // the worst case, libstdc++'s prime bucket counts hide it
+      rehash_counted<std::unordered_map<long, int>> m;
+      for (size_t i = 0; i < N; ++i) m[(long) (i*1024)] = 0;
+      cout << "unordered_map<long,int>, keys i*1024:\n";
+      printHashTableStats(hash_table_stats(m));
+   }
+   {
+      struct BadHash { size_t operator()(long v) const { return v & 0xff; } };
+      rehash_counted<std::unordered_set<long, BadHash>> s;
+      for (long i = 0; i < 20000; ++i) s.insert(i);
+      cout << "unordered_set<long, BadHash> (only 256 distinct hash values):\n";
+      printHashTableStats(hash_table_stats(s));
+   }
+   {
+      flat_hash_map<Customer, int, CustomerHash_wyhash> customer_map;
+      for (const auto& c : customers) customer_map.emplace(c, 0);
+      cout << "flat_hash_map<Customer, int, CustomerHash_wyhash>:\n";
+      printHashTableStats(hash_table_stats(customer_map));
+   }
+   cout << "–––\n";
+   {
+      // cost of a full scan vs a sampled one
+      std::unordered_map<long, int> m;
+      for (size_t i = 0; i < 10*N; ++i) m[(long) i] = 0;
+      bench_harness bench(1, 5);
+      bench_harness::print_stats(cout, "hash_table_stats, 10M elements, all buckets",
+         bench.measure([&]{ do_not_optimize(hash_table_stats(m).observed_probe_cost); }));
+      bench_harness::print_stats(cout, "hash_table_stats, 10M elements, 4096 sampled buckets",
+         bench.measure([&]{ do_not_optimize(hash_table_stats(m, 4096).observed_probe_cost); }));
+      cout << "sampled:\n";
+      printHashTableStats(hash_table_stats(m, 4096));
+   }
+}
+
+// for 'testing_heterogeneous_lookup'
+/*
+   counting allocations: replacing the global operator new/delete (affects the whole program)
+   - counted only while an allocation_counter is alive (g_count_allocations): otherwise an allocation
+     costs 1 relaxed load more, no atomic read-modify-write on a shared cache line, so the
+     allocation-heavy (and multithreaded) benchmarks elsewhere are not skewed
+   - the array and aligned forms are not replaced, the default ones forward to these
+   - noinline: once inlined, gcc sees 'free' on memory from 'operator new' (-Wmismatched-new-delete)
+*/
+std::atomic<bool> g_count_allocations{false};
+std::atomic<size_t> g_n_allocations{0};
+__attribute__((noinline)) void* operator new(std::size_t n)
+{
+   if (g_count_allocations.load(std::memory_order_relaxed)) {
+      g_n_allocations.fetch_add(1, std::memory_order_relaxed);
+   }
+   if (void* p = std::malloc(n ? n : 1)) {
+      return p;
+   }
+   throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+// counts the allocations (of all threads) during its lifetime, not nestable
+class allocation_counter {
+public:
+   allocation_counter() : m_before(g_n_allocations.load()) { g_count_allocations.store(true); }
+   ~allocation_counter() { g_count_allocations.store(false); }
+   allocation_counter(const allocation_counter&) = delete;
+   allocation_counter& operator=(const allocation_counter&) = delete;
+   size_t count() const { return g_n_allocations.load() - m_before; }
+private:
+   size_t m_before;
+};
+
+void testing_heterogeneous_lookup()
+{
+   const size_t N = 1000000;
+   // names longer than the SSO buffer (15 chars with libstdc++), otherwise constructing
+   // the Customer for a lookup allocates nothing anyway
+   std::vector<Customer> customers = make_customers(N);
+   for (auto& c : customers) {
+      c.first_name += "-Maria-Theresia";
+      c.last_name += " von Hohenzollern";
+   }
+   // queries come from somewhere else (a parsed request, a file buffer): views into a separate copy
+   const std::vector<Customer> query_storage = customers;
+   std::vector<CustomerKey> queries;
+   for (const auto& c : query_storage) {
+      queries.push_back({c.first_name, c.last_name, c.no});
+   }
+   std::shuffle(queries.begin(), queries.end(), std::mt19937(1));
+
+   std::unordered_map<Customer, int, CustomerHash_better> customer_map;
+   flat_hash_map<Customer, int, CustomerHash_better, CustomerEqual> flat_better;
+   flat_hash_map<Customer, int, CustomerHash_wyhash, CustomerEqual> flat_wyhash;
+   flat_hash_map<Customer, int, CustomerHash_no, CustomerEqual> flat_no;
+   for (const auto& c : customers) {
+      customer_map.emplace(c, 1);
+      flat_better.emplace(c, 1);
+      flat_wyhash.emplace(c, 1);
+      flat_no.emplace(c, 1);
+   }
+
+   // small demo
+   {
+      const CustomerKey& k = queries.front();
+      cout << "find(CustomerKey{\"" << k.first_name << "\", \"" << k.last_name << "\", " << k.no << "}): "
+           << flat_better.find(k)->first << "\n";
+      cout << "find(" << k.no << "L):  " << flat_no.find(k.no)->first << "\n";
+      cout << "count(-1L): " << flat_no.count(-1L) << "\n";
+   }
+
+   bench_harness bench(1, 5);
+   auto run = [&](const std::string& name, auto lookup) {
+      size_t n_found = 0;
+      double allocs_per_lookup = 0.0;
+      {
+         const allocation_counter allocations;
+         for (const auto& q : queries) { n_found += lookup(q); }
+         allocs_per_lookup = (double) allocations.count()/queries.size();
+      }
+      const auto st = bench.measure([&]{
+         for (const auto& q : queries) { n_found += lookup(q); }
+      });
+      do_not_optimize(n_found);
+      cout << std::left << std::setw(62) << name << std::right
+           << " allocs/lookup: " << std::setw(4) << allocs_per_lookup
+           << "  ns/lookup: " << (double) st.median/queries.size() << "\n";
+   };
+   run("unordered_map<Customer,..,CustomerHash_better>::find(Customer)", [&](const CustomerKey& q) {
+      return customer_map.find(Customer{std::string(q.first_name), std::string(q.last_name), q.no}) != customer_map.end();
+   });
+   run("flat_hash_map<Customer,..,CustomerHash_better>::find(Customer)", [&](const CustomerKey& q) {
+      return flat_better.find(Customer{std::string(q.first_name), std::string(q.last_name), q.no}) != flat_better.end();
+   });
+   run("flat_hash_map<Customer,..,CustomerHash_better>::find(CustomerKey)", [&](const CustomerKey& q) {
+      return flat_better.find(q) != flat_better.end();
+   });
+   run("flat_hash_map<Customer,..,CustomerHash_wyhash>::find(CustomerKey)", [&](const CustomerKey& q) {
+      return flat_wyhash.find(q) != flat_wyhash.end();
+   });
+   run("flat_hash_map<Customer,..,CustomerHash_no>::find(long)", [&](const CustomerKey& q) {
+      return flat_no.find(q.no) != flat_no.end();
+   });
+}
+
+// for 'testing_hash_cached'
+/*
+   hash_cached<T,Hash>: a value plus its hash, computed once at construction
+   - the value is only accessible as const, as the cached hash must stay valid
+   - hasher: returns the cached hash (noexcept, no access to the strings)
+   - operator==: compares the cached hashes first, the values only if they are equal
+   - what this saves depends on the container:
+      - flat_hash_map rehash() recomputes the hash of every element => saved
+      - libstdc++'s unordered_map already stores the hash code in each node if the hasher is
+        not noexcept (as CustomerHash_better) or not "fast" (std::hash<std::string>),
+        so growing it does not call the hasher again anyway
+        => there the wrapper moves the hash code from the node into the key (its hasher is noexcept
+           and "fast", so the node stores no second copy)
+   - measured (5M customers, -O2): growing unordered_map ~15% faster, flat_hash_map unchanged although
+     the hash calls drop from ~2.5 to 1 per element: rehash() is dominated by the cache misses of
+     moving the 80-byte slots, not by hashing the short names
+*/
+// Args is a single Self (any cv/ref): the forwarding ctor must leave that to the copy/move ctors
+template <typename Self, typename... Args>
+struct is_self_arg : std::false_type {};
+template <typename Self, typename Arg>
+struct is_self_arg<Self, Arg> : std::is_same<std::decay_t<Arg>, Self> {};
+template <typename T, typename Hash>
+class hash_cached {
+public:
+   template <typename... Args, typename = std::enable_if_t<!is_self_arg<hash_cached, Args...>::value>>
+   explicit hash_cached(Args&&... args) : m_value(std::forward<Args>(args)...), m_hash(Hash()(m_value)) {}
+
+   const T& value() const { return m_value; }
+   size_t hash() const { return m_hash; }
+
+   friend bool operator==(const hash_cached& h1, const hash_cached& h2) {
+      return h1.m_hash == h2.m_hash && h1.m_value == h2.m_value;
+   }
+   friend bool operator!=(const hash_cached& h1, const hash_cached& h2) { return !(h1 == h2); }
+
+   struct hasher {
+      size_t operator() (const hash_cached& h) const noexcept { return h.m_hash; }
+   };
+
+private:
+   T m_value;
+   size_t m_hash;
+};
+// counts the calls of the wrapped hasher (keeps its noexcept-ness, which decides libstdc++'s hash code caching)
+template <typename Hash>
+struct counting_hash {
+   static inline size_t n_calls = 0;
+   template <typename K>
+   size_t operator() (const K& key) const noexcept(noexcept(Hash()(key))) {
+      ++n_calls;
+      return Hash()(key);
+   }
+};
+
+void testing_hash_cached()
+{
+   const size_t N = 5000000;
+   const std::vector<Customer> customers = make_customers(N);
+   using CustomerCached = hash_cached<Customer, counting_hash<CustomerHash_better>>;
+   {
+      const CustomerCached c1(Customer{"Max", "Mustermann", 42});
+      const CustomerCached c2(Customer{"Max", "Mustermann", 42});
+      cout << c1.value() << " hash: " << c1.hash() << ", == " << c2.value() << ": " << std::boolalpha << (c1 == c2) << "\n";
+      // copy and move of a non-const lvalue: the copy/move ctors, not the forwarding one
+      CustomerCached c3(Customer{"Bob", "Smith", 1});
+      CustomerCached c4(c3);
+      CustomerCached c5(std::move(c4));
+      cout << c5.value() << " copied and moved, == original: " << (c5 == c3) << "\n";
+      cout << std::noboolalpha;
+   }
+
+   // grow from empty without reserve(), the container is created in the (untimed) setup
+   // and destroyed in the next setup
+   bench_harness bench(0, 3);
+   auto run = [&](const std::string& name, auto make_cont, auto insert_all) {
+      std::unique_ptr<decltype(make_cont())> cont;
+      counting_hash<CustomerHash_better>::n_calls = 0;
+      const auto st = bench.measure(
+         [&]{ insert_all(*cont); },
+         [&]{ cont.reset(); cont.reset(new decltype(make_cont())()); });
+      const double calls_per_elem = (double) counting_hash<CustomerHash_better>::n_calls/(bench.n_reps()*N);
+      cont.reset();
+      cout << std::left << std::setw(58) << name << std::right
+           << " hash calls/element: " << std::setw(4) << calls_per_elem
+           << "  ns/insert: " << (double) st.median/N << "\n";
+   };
+   run("unordered_map<Customer,int,CustomerHash_better>",
+      []{ return std::unordered_map<Customer, int, counting_hash<CustomerHash_better>>(); },
+      [&](auto& m){ for (const auto& c : customers) m.emplace(c, 0); });
+   run("unordered_map<hash_cached<Customer>,int>",
+      []{ return std::unordered_map<CustomerCached, int, CustomerCached::hasher>(); },
+      [&](auto& m){ for (const auto& c : customers) m.emplace(CustomerCached(c), 0); });
+   run("flat_hash_map<Customer,int,CustomerHash_better>",
+      []{ return flat_hash_map<Customer, int, counting_hash<CustomerHash_better>>(); },
+      [&](auto& m){ for (const auto& c : customers) m.emplace(c, 0); });
+   run("flat_hash_map<hash_cached<Customer>,int>",
+      []{ return flat_hash_map<CustomerCached, int, CustomerCached::hasher>(); },
+      [&](auto& m){ for (const auto& c : customers) m.emplace(CustomerCached(c), 0); });
+}
+
+// for 'testing_container_reference_semantics' (p.388)
+struct Item {
+   std::string name;
+   float price;
+   
+   Item(const std::string& n, float p=0.0)
+      : name(n), price(p) {}
+};
+
+template<typename T>
+void printItems(const std::string& msg, const T& container) {
+   cout << msg << "\n";
+   for (const auto& e : container) {
+      cout << " " << e->name << ": " << e->price << "\n";
+   }
+}
+void testing_container_reference_semantics()
+{
+   {
+      typedef std::shared_ptr<Item> ItemPtr;
+      std::set<ItemPtr> allItems;
+      std::deque<ItemPtr> bestsellers;
+
+      bestsellers = {
+         std::make_shared<Item>("Kong Yize",20.10),
+         std::make_shared<Item>("A Midsummer Night's Dream",14.99),
          std::make_shared<Item>("A Maltese Falcon",9.88)
       };
       allItems = {
@@ -3248,6 +5086,7 @@ void testing_multiple_sorting_criteria()
    // even same first_name AND last_name would occur multiple times
    // => shouldn't use set then! but maybe multiset?
    // TODO: what about relative order, when last_name/first_name matches, sort by other name, then by no?
+   //       => 'multi_key_sort' (see 'testing_multi_key_sort')
    Customer c1  = {"Max",  "Mustermann", 42};
    Customer c2  = {"Bob",  "Smith",       1};
    Customer c3  = {"Anna", "Black",       2};
@@ -3308,29 +5147,972 @@ void testing_multiple_sorting_criteria()
    }
 }
 
-void testing_processing_adjacent_elements()
+// for 'testing_multi_index_store'
+/*
+   parallel_sort: the chunks are sorted concurrently (std::async), then merged pairwise,
+   the merges of one round run concurrently as well => O(n log n) work
+   - not stable: comp must be a strict total order if a deterministic result is needed
+   - C++17's std::sort(std::execution::par, ...) needs TBB with libstdc++
+*/
+template <typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp, unsigned n_threads = std::thread::hardware_concurrency())
 {
-   // p.437
-   //int arr[] = { 1,1,1,2,2,3,4,4,4,4,5,6,6 };
-   int arr[] = { 1,1,1,2,2,3,4,4,4,4,5,6,6,99 };
-   //int arr[] = { 1,1 };
-   //int arr[] = { 1,2 };
-   //int arr[] = { 1,1,1 };
-   //int arr[] = { 1,2,3 };
+   const size_t n = last - first;
+   if (n_threads <= 1 || n < 100000) {
+      std::sort(first, last, comp);
+      return;
+   }
+   std::vector<size_t> bounds;
+   for (size_t i = 0; i <= n_threads; ++i) {
+      bounds.push_back(n*i/n_threads);
+   }
+   std::vector<std::future<void>> tasks;
+   for (size_t i = 0; i < n_threads; ++i) {
+      tasks.push_back(std::async(std::launch::async, [=]{ std::sort(first+bounds[i], first+bounds[i+1], comp); }));
+   }
+   for (auto& t : tasks) t.get();
+   for (size_t width = 1; width < n_threads; width *= 2) {
+      tasks.clear();
+      for (size_t i = 0; i + width < n_threads; i += 2*width) {
+         const size_t hi = bounds[std::min<size_t>(i + 2*width, n_threads)];
+         tasks.push_back(std::async(std::launch::async, [=]{
+            std::inplace_merge(first+bounds[i], first+bounds[i+width], first+hi, comp);
+         }));
+      }
+      for (auto& t : tasks) t.get();
+   }
+}
+template <typename RandomIt>
+void parallel_sort(RandomIt first, RandomIt last)
+{
+   parallel_sort(first, last, std::less<typename std::iterator_traits<RandomIt>::value_type>());
+}
+/*
+   multi_index_vector<T, Projections...>: the rows stored once, contiguously, plus one sorted index per projection
+   - instead of one std::multiset<T*> per sorting criterion (p.394): each multiset node is a
+     red-black tree node (3 pointers + color + the T*, 40 bytes, 48 with malloc's overhead)
+     => here an index entry is the row number (uint32_t), 4 bytes
+   - a projection maps a row to its sort key, e.g. 'const std::string& operator()(const Customer&)'
+   - equal keys are ordered by row number, i.e. by insertion order (as equal elements in a multiset)
+   - bulk build: O(n log n), every index sorted with parallel_sort
+   - insert(row): O(n) per index (memmove of 4-byte entries), insert(first,last): append,
+     sort the new entries, merge => O(n + k log k)
+   - rows are only accessible as const (changing a key would break the indices), no erase
+*/
+template <typename T, typename... Projections>
+class multi_index_vector {
+public:
+   static constexpr size_t n_indices = sizeof...(Projections);
+
+   // a range of rows in the order of one index
+   class index_range {
+   public:
+      class iterator {
+      public:
+         using iterator_category = std::random_access_iterator_tag;
+         using value_type = T;
+         using difference_type = std::ptrdiff_t;
+         using pointer = const T*;
+         using reference = const T&;
+
+         iterator(const T* rows, const uint32_t* pos) : m_rows(rows), m_pos(pos) {}
+         reference operator*() const { return m_rows[*m_pos]; }
+         pointer operator->() const { return &m_rows[*m_pos]; }
+         reference operator[](difference_type n) const { return m_rows[m_pos[n]]; }
+         iterator& operator++() { ++m_pos; return *this; }
+         iterator operator++(int) { iterator tmp(*this); ++m_pos; return tmp; }
+         iterator& operator--() { --m_pos; return *this; }
+         iterator operator--(int) { iterator tmp(*this); --m_pos; return tmp; }
+         iterator& operator+=(difference_type n) { m_pos += n; return *this; }
+         iterator& operator-=(difference_type n) { m_pos -= n; return *this; }
+         friend iterator operator+(iterator it, difference_type n) { return it += n; }
+         friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+         friend difference_type operator-(const iterator& it1, const iterator& it2) { return it1.m_pos - it2.m_pos; }
+         friend bool operator==(const iterator& it1, const iterator& it2) { return it1.m_pos == it2.m_pos; }
+         friend bool operator!=(const iterator& it1, const iterator& it2) { return it1.m_pos != it2.m_pos; }
+         friend bool operator<(const iterator& it1, const iterator& it2) { return it1.m_pos < it2.m_pos; }
+         // row number in the store
+         uint32_t row() const { return *m_pos; }
+
+      private:
+         const T* m_rows;
+         const uint32_t* m_pos;
+      };
 
-   int *pos, *pos_ahead, *end;
-   pos = pos_ahead = arr;
-   const int n_elems = sizeof(arr)/sizeof(arr[0]);
-   end = &arr[n_elems];
-   
-   auto print_arr = [&arr]() {
-      cout << "arr (vals): ";
-      for (const auto& e : arr) { cout << std::setw(2) << e << " "; }
-      cout << "\n";
-      
-      cout << "arr (idxs): ";
-      for (size_t i=0; i < std::size(arr); ++i) { cout << std::setw(2) << i << " "; }
-      cout << "\n";
+      index_range(const T* rows, const uint32_t* first, const uint32_t* last) : m_rows(rows), m_first(first), m_last(last) {}
+      iterator begin() const { return iterator(m_rows, m_first); }
+      iterator end() const { return iterator(m_rows, m_last); }
+      size_t size() const { return m_last - m_first; }
+      bool empty() const { return m_first == m_last; }
+
+   private:
+      const T* m_rows;
+      const uint32_t* m_first;
+      const uint32_t* m_last;
+   };
+
+   multi_index_vector() = default;
+   // bulk build
+   explicit multi_index_vector(std::vector<T> rows, unsigned n_threads = std::thread::hardware_concurrency())
+      : m_rows(std::move(rows))
+   {
+      check_size(m_rows.size());
+      for_each_index([&](auto I) {
+         auto& idx = m_indices[I];
+         idx.resize(m_rows.size());
+         std::iota(idx.begin(), idx.end(), 0);
+         parallel_sort(idx.begin(), idx.end(), row_less<I>(), n_threads);
+      });
+   }
+
+   size_t size() const { return m_rows.size(); }
+   const T& operator[](size_t row) const { return m_rows[row]; }
+   const std::vector<T>& rows() const { return m_rows; }
+
+   void insert(T row) {
+      check_size(m_rows.size() + 1);
+      const uint32_t id = m_rows.size();
+      m_rows.push_back(std::move(row));
+      // the new row number is the largest => its position is after all equal keys
+      for_each_index([&](auto I) {
+         auto& idx = m_indices[I];
+         const auto& proj = std::get<I>(m_proj);
+         auto pos = std::upper_bound(idx.begin(), idx.end(), proj(m_rows[id]),
+            [&](const auto& k, uint32_t r) { return k < proj(m_rows[r]); });
+         idx.insert(pos, id);
+      });
+   }
+   template <typename InputIt>
+   void insert(InputIt first, InputIt last) {
+      const size_t old_size = m_rows.size();
+      m_rows.insert(m_rows.end(), first, last);
+      // an input range can only be counted by inserting it => undo the insert if it is too large
+      try {
+         check_size(m_rows.size());
+      } catch (...) {
+         m_rows.erase(m_rows.begin() + old_size, m_rows.end());
+         throw;
+      }
+      for_each_index([&](auto I) {
+         auto& idx = m_indices[I];
+         for (size_t r = old_size; r < m_rows.size(); ++r) {
+            idx.push_back(r);
+         }
+         std::sort(idx.begin() + old_size, idx.end(), row_less<I>());
+         std::inplace_merge(idx.begin(), idx.begin() + old_size, idx.end(), row_less<I>());
+      });
+   }
+
+   // all rows in the order of index I
+   template <size_t I>
+   index_range index() const {
+      return range_of(m_indices[I].data(), m_indices[I].data() + m_indices[I].size());
+   }
+   // rows whose key (of index I) equals key
+   template <size_t I, typename K>
+   index_range equal_range(const K& key) const {
+      return range<I>(key, key, true);
+   }
+   // rows with lo <= key < hi (or lo <= key <= hi if inclusive)
+   template <size_t I, typename K1, typename K2>
+   index_range range(const K1& lo, const K2& hi, bool inclusive = false) const {
+      const auto& idx = m_indices[I];
+      const auto& proj = std::get<I>(m_proj);
+      auto first = std::lower_bound(idx.begin(), idx.end(), lo,
+         [&](uint32_t r, const K1& k) { return proj(m_rows[r]) < k; });
+      auto last = inclusive
+         ? std::upper_bound(first, idx.end(), hi, [&](const K2& k, uint32_t r) { return k < proj(m_rows[r]); })
+         : std::lower_bound(first, idx.end(), hi, [&](uint32_t r, const K2& k) { return proj(m_rows[r]) < k; });
+      // not &*first: first may be idx.end() (lo above all keys, empty store)
+      const uint32_t* b = idx.data() + (first - idx.begin());
+      return range_of(b, b + (last - first));
+   }
+
+   // bytes used by the indices (capacity, as with the rows)
+   size_t index_bytes() const {
+      size_t bytes = 0;
+      for (const auto& idx : m_indices) bytes += idx.capacity()*sizeof(uint32_t);
+      return bytes;
+   }
+
+private:
+   template <size_t I>
+   struct row_less_t {
+      const multi_index_vector* self;
+      bool operator() (uint32_t r1, uint32_t r2) const {
+         const auto& proj = std::get<I>(self->m_proj);
+         const auto& k1 = proj(self->m_rows[r1]);
+         const auto& k2 = proj(self->m_rows[r2]);
+         return k1 < k2 || (!(k2 < k1) && r1 < r2);
+      }
+   };
+   template <size_t I>
+   row_less_t<I> row_less() const { return row_less_t<I>{this}; }
+
+   template <typename F>
+   static void for_each_index(F f) { for_each_index(f, std::make_index_sequence<n_indices>()); }
+   template <typename F, size_t... Is>
+   static void for_each_index(F f, std::index_sequence<Is...>) { (f(std::integral_constant<size_t, Is>()), ...); }
+
+   static void check_size(size_t n) {
+      if (n > std::numeric_limits<uint32_t>::max()) throw std::length_error("multi_index_vector: too many rows");
+   }
+   index_range range_of(const uint32_t* first, const uint32_t* last) const {
+      return index_range(m_rows.data(), first, last);
+   }
+
+   std::vector<T> m_rows;
+   std::array<std::vector<uint32_t>, n_indices> m_indices;
+   std::tuple<Projections...> m_proj;
+};
+// projections for the 3 sorting criteria of 'testing_multiple_sorting_criteria'
+struct Customer_by_firstName {
+   const std::string& operator() (const Customer& c) const { return c.first_name; }
+};
+struct Customer_by_lastName {
+   const std::string& operator() (const Customer& c) const { return c.last_name; }
+};
+struct Customer_by_customerNo {
+   long operator() (const Customer& c) const { return c.no; }
+};
+using CustomerStore = multi_index_vector<Customer, Customer_by_firstName, Customer_by_lastName, Customer_by_customerNo>;
+enum CustomerStoreIndex : size_t { BY_FIRST_NAME, BY_LAST_NAME, BY_NO };
+
+void testing_multi_index_store()
+{
+   // the customers of 'testing_multiple_sorting_criteria'
+   CustomerStore store({
+      {"Max",  "Mustermann", 42}, {"Bob",  "Smith",       1}, {"Anna", "Black",       2},
+      {"Jack", "Smith",       5}, {"Jane", "Doe",        19}, {"Zulu", "Akebe",       7},
+      {"Greg", "Doherty",    33}, {"Paul", "Walker",      8}, {"Peter", "Pan",        9},
+      {"Paul", "Potz",       10}, {"Ellen", "Pan",       11}, {"Ellen", "Pan",       22}
+   });
+   cout << "customers sorted by first name:\n";
+   for (const auto& c : store.index<BY_FIRST_NAME>()) {
+      cout << "  " << c.first_name << "," << c.last_name << "," << c.no << "\n";
+   }
+   cout << "customers sorted by last name:\n";
+   for (const auto& c : store.index<BY_LAST_NAME>()) {
+      cout << "  " << c.first_name << "," << c.last_name << "," << c.no << "\n";
+   }
+   cout << "customers sorted by customer no.:\n";
+   for (const auto& c : store.index<BY_NO>()) {
+      cout << "  " << c.no << "," << c.first_name << "," << c.last_name << "\n";
+   }
+   store.insert({"Ellen", "Parker", 3});
+   cout << "last name == \"Pan\":          ";
+   for (const auto& c : store.equal_range<BY_LAST_NAME>("Pan")) cout << c << " ";
+   cout << "\nlast name in [\"D\",\"P\"):      ";
+   for (const auto& c : store.range<BY_LAST_NAME>("D", "P")) cout << c << " ";
+   cout << "\nno in [3,9]:                 ";
+   for (const auto& c : store.range<BY_NO>(3L, 9L, true)) cout << c << " ";
+   cout << "\nfirst name == \"Ellen\":       ";
+   for (const auto& c : store.equal_range<BY_FIRST_NAME>("Ellen")) cout << c << " ";
+   cout << "\n";
+   // keys beyond the last one and an empty store: empty ranges
+   cout << "no == 1000: " << store.equal_range<BY_NO>(1000L).size() << " rows, last name >= \"Zz\": "
+        << store.range<BY_LAST_NAME>("Zz", "zz").size() << " rows, in an empty store: "
+        << CustomerStore().equal_range<BY_LAST_NAME>("Pan").size() << " rows\n";
+
+   cout << "–––\n";
+   // 1M customers: 3 multisets of pointers vs one store
+   const size_t N = 1000000;
+   std::vector<Customer> customers = make_customers(N);
+   const auto n_threads = std::max(1u, std::thread::hardware_concurrency());
+   struct CustomerSortCriterion_by_firstName {
+      bool operator() (const Customer* c1, const Customer* c2) const { return c1->first_name < c2->first_name; }
+   };
+   struct CustomerSortCriterion_by_lastName {
+      bool operator() (const Customer* c1, const Customer* c2) const { return c1->last_name < c2->last_name; }
+   };
+   struct CustomerSortCriterion_by_customerNo {
+      bool operator() (const Customer* c1, const Customer* c2) const { return c1->no < c2->no; }
+   };
+   std::multiset<Customer*,CustomerSortCriterion_by_firstName> by_first_name;
+   std::multiset<Customer*,CustomerSortCriterion_by_lastName> by_last_name;
+   std::multiset<Customer*,CustomerSortCriterion_by_customerNo> by_no;
+   bench_harness bench(0, 3);
+   bench_harness::print_stats(cout, "3 multisets: insert 1M pointers each",
+      bench.measure([&]{
+         for (auto& c : customers) {
+            by_first_name.insert(&c);
+            by_last_name.insert(&c);
+            by_no.insert(&c);
+         }
+      }, [&]{ by_first_name.clear(); by_last_name.clear(); by_no.clear(); }));
+   std::unique_ptr<CustomerStore> big_store;
+   bench_harness::print_stats(cout, "multi_index_vector: bulk build, " + std::to_string(n_threads) + " thread(s)",
+      bench.measure([&]{
+         big_store.reset(new CustomerStore(customers, n_threads));
+      }, [&]{ big_store.reset(); }));
+
+   // node size of a std::multiset<Customer*>: libstdc++'s _Rb_tree_node_base (color + 3 pointers) + the value
+   const size_t node_bytes = 4*sizeof(void*) + sizeof(Customer*);
+   cout << "bytes per element and index: multiset " << node_bytes << " (+ malloc overhead, ~48), "
+        << "multi_index_vector " << (double) big_store->index_bytes()/(3*big_store->size()) << "\n";
+
+   // range queries: all customers whose last name starts with "Ka"
+   size_t n_found = 0;
+   bench_harness::print_stats(cout, "multisets: last name in [\"Ka\",\"Kb\")",
+      bench.measure([&]{
+         Customer lo{"", "Ka", 0}, hi{"", "Kb", 0};
+         auto first = by_last_name.lower_bound(&lo);
+         auto last = by_last_name.lower_bound(&hi);
+         for (; first != last; ++first) n_found += (*first)->no & 1;
+      }));
+   bench_harness::print_stats(cout, "multi_index_vector: last name in [\"Ka\",\"Kb\")",
+      bench.measure([&]{
+         for (const auto& c : big_store->range<BY_LAST_NAME>("Ka", "Kb")) n_found += c.no & 1;
+      }));
+   cout << "customers with last name \"Ka...\": " << big_store->range<BY_LAST_NAME>("Ka", "Kb").size() << "\n";
+
+   // incremental inserts
+   const std::vector<Customer> more = make_customers(1000, 7);
+   bench_harness bench_once(0, 1);
+   bench_harness::print_stats(cout, "multi_index_vector: insert 1000 rows one by one",
+      bench_once.measure([&]{ for (const auto& c : more) big_store->insert(c); }), more.size());
+   bench_harness::print_stats(cout, "multi_index_vector: insert 1000 rows as a batch",
+      bench_once.measure([&]{ big_store->insert(more.begin(), more.end()); }), more.size());
+   do_not_optimize(n_found);
+}
+
+// for 'testing_customer_table'
+/*
+   runtime dispatch for the AVX2 code paths: functions marked __attribute__((target("avx2")))
+   may only be called if the CPU supports AVX2, the rest of the program stays baseline x86-64 (SSE2)
+*/
+inline bool cpu_has_avx2() {
+   static const bool has_avx2 = __builtin_cpu_supports("avx2");
+   return has_avx2;
+}
+/*
+   CustomerTable: Customer as struct of arrays (columnar)
+   - std::vector<Customer>: 72 bytes per row (2 std::string + long), scanning 'no' reads 1 of 9 words
+     of every row => a scan by 'no' streams the whole 72 bytes/row through the caches
+   - here: 'no' is a contiguous int64 column (8 bytes/row), the names are packed back to back in
+     one char arena per column, row i is arena[offsets[i], offsets[i+1]) (uint32 offsets => < 4 GiB per column)
+   - last_name_prefix8: the first 8 bytes of last_name (zero padded), so that a prefix match of up to 8 chars
+     is a single 64-bit compare, 4 rows per AVX2 instruction
+   - filters write the matching row numbers into a selection vector (selection_t): its allocator
+     default-initializes, so growing it by size() rows before a scan does not zero-fill them
+   - append only, rows are materialized as string_views or as Customer via row()
+*/
+class CustomerTable {
+public:
+   using selection_t = std::vector<uint32_t, default_init_allocator<uint32_t>>;
+
+   CustomerTable() {
+      m_first_name_offsets.push_back(0);
+      m_last_name_offsets.push_back(0);
+   }
+
+   void reserve(size_t n_rows, size_t n_chars_per_name_column = 0) {
+      m_no.reserve(n_rows);
+      m_last_name_prefix8.reserve(n_rows);
+      m_first_name_offsets.reserve(n_rows+1);
+      m_last_name_offsets.reserve(n_rows+1);
+      m_first_name_arena.reserve(n_chars_per_name_column);
+      m_last_name_arena.reserve(n_chars_per_name_column);
+   }
+   void push_back(std::string_view first_name, std::string_view last_name, long no) {
+      if (m_first_name_arena.size() + first_name.size() > std::numeric_limits<uint32_t>::max() ||
+          m_last_name_arena.size() + last_name.size() > std::numeric_limits<uint32_t>::max()) {
+         throw std::length_error("CustomerTable: name arena exceeds 4 GiB");
+      }
+      m_no.push_back(no);
+      uint64_t prefix8 = 0;
+      memcpy(&prefix8, last_name.data(), std::min<size_t>(last_name.size(), 8));
+      m_last_name_prefix8.push_back(prefix8);
+      m_first_name_arena.insert(m_first_name_arena.end(), first_name.begin(), first_name.end());
+      m_last_name_arena.insert(m_last_name_arena.end(), last_name.begin(), last_name.end());
+      m_first_name_offsets.push_back(m_first_name_arena.size());
+      m_last_name_offsets.push_back(m_last_name_arena.size());
+   }
+   void push_back(const Customer& c) { push_back(c.first_name, c.last_name, c.no); }
+
+   size_t size() const { return m_no.size(); }
+   long no(size_t row) const { return m_no[row]; }
+   std::string_view first_name(size_t row) const {
+      return {m_first_name_arena.data() + m_first_name_offsets[row], m_first_name_offsets[row+1] - m_first_name_offsets[row]};
+   }
+   std::string_view last_name(size_t row) const {
+      return {m_last_name_arena.data() + m_last_name_offsets[row], m_last_name_offsets[row+1] - m_last_name_offsets[row]};
+   }
+   Customer row(size_t row) const {
+      return Customer{std::string(first_name(row)), std::string(last_name(row)), no(row)};
+   }
+   size_t bytes() const {
+      return m_no.capacity()*sizeof(int64_t) + m_last_name_prefix8.capacity()*sizeof(uint64_t) +
+             (m_first_name_offsets.capacity() + m_last_name_offsets.capacity())*sizeof(uint32_t) +
+             m_first_name_arena.capacity() + m_last_name_arena.capacity();
+   }
+
+   // rows with lo <= no <= hi, appended to 'sel', returns the number of matches
+   size_t filter_no_range(long lo, long hi, selection_t& sel) const {
+      const size_t n_before = sel.size();
+      sel.resize(n_before + size());
+      uint32_t* out = sel.data() + n_before;
+      const size_t n = cpu_has_avx2() ? filter_no_range_avx2(lo, hi, out) : filter_no_range_scalar(lo, hi, out, 0);
+      sel.resize(n_before + n);
+      return n;
+   }
+   // rows whose last_name starts with 'prefix', appended to 'sel', returns the number of matches
+   size_t filter_last_name_prefix(std::string_view prefix, selection_t& sel) const {
+      const size_t n_before = sel.size();
+      sel.resize(n_before + size());
+      uint32_t* out = sel.data() + n_before;
+      // the first (up to) 8 bytes are compared in the prefix8 column, masked to the prefix length
+      const size_t n8 = std::min<size_t>(prefix.size(), 8);
+      uint64_t needle = 0;
+      memcpy(&needle, prefix.data(), n8);
+      const uint64_t mask = n8 == 8 ? ~0ULL : (1ULL << 8*n8) - 1;
+      // a prefix longer than 8 bytes or containing '\0' (which also matches the zero padding)
+      // needs to be checked against the arena
+      const bool verify = prefix.size() > 8 || prefix.find('\0') != std::string_view::npos;
+      size_t n = cpu_has_avx2() ? filter_prefix8_avx2(needle, mask, out) : filter_prefix8_scalar(needle, mask, out, 0);
+      if (verify) {
+         size_t n_verified = 0;
+         for (size_t i = 0; i < n; ++i) {
+            const std::string_view name = last_name(out[i]);
+            if (name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0) {
+               out[n_verified++] = out[i];
+            }
+         }
+         n = n_verified;
+      }
+      sel.resize(n_before + n);
+      return n;
+   }
+   // the same filters as a plain loop over the columns (for comparison, and the non-AVX2 fallback)
+   size_t filter_no_range_scalar(long lo, long hi, uint32_t* out, size_t first_row) const {
+      size_t n = 0;
+      for (size_t row = first_row; row < size(); ++row) {
+         out[n] = row;
+         n += (m_no[row] >= lo) & (m_no[row] <= hi);   // branchless: always write, advance on match
+      }
+      return n;
+   }
+   size_t filter_prefix8_scalar(uint64_t needle, uint64_t mask, uint32_t* out, size_t first_row) const {
+      size_t n = 0;
+      for (size_t row = first_row; row < size(); ++row) {
+         out[n] = row;
+         n += (m_last_name_prefix8[row] & mask) == needle;
+      }
+      return n;
+   }
+
+private:
+   // 4 rows per iteration: a 4-bit match mask, the matching row numbers are written via a
+   // lookup table of the (up to 4) set bits' positions
+   static const std::array<std::array<uint8_t,4>,16>& match_positions() {
+      static const auto table = []{
+         std::array<std::array<uint8_t,4>,16> t{};
+         for (unsigned m = 0; m < 16; ++m) {
+            unsigned k = 0;
+            for (unsigned bit = 0; bit < 4; ++bit) {
+               if (m & (1u << bit)) t[m][k++] = bit;
+            }
+         }
+         return t;
+      }();
+      return table;
+   }
+   static size_t emit_matches(unsigned mask, size_t row, uint32_t* out) {
+      const auto& pos = match_positions()[mask];
+      out[0] = row + pos[0];
+      out[1] = row + pos[1];
+      out[2] = row + pos[2];
+      out[3] = row + pos[3];
+      return __builtin_popcount(mask);
+   }
+   __attribute__((target("avx2")))
+   size_t filter_no_range_avx2(long lo, long hi, uint32_t* out) const {
+      const __m256i lo_v = _mm256_set1_epi64x(lo);
+      const __m256i hi_v = _mm256_set1_epi64x(hi);
+      size_t n = 0;
+      size_t row = 0;
+      for (; row + 4 <= size(); row += 4) {
+         const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_no.data() + row));
+         // outside = lo > v || v > hi
+         const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lo_v, v), _mm256_cmpgt_epi64(v, hi_v));
+         const unsigned mask = ~_mm256_movemask_pd(_mm256_castsi256_pd(outside)) & 0xf;
+         n += emit_matches(mask, row, out + n);
+      }
+      return n + filter_no_range_scalar(lo, hi, out + n, row);
+   }
+   __attribute__((target("avx2")))
+   size_t filter_prefix8_avx2(uint64_t needle, uint64_t mask, uint32_t* out) const {
+      const __m256i needle_v = _mm256_set1_epi64x(needle);
+      const __m256i mask_v = _mm256_set1_epi64x(mask);
+      size_t n = 0;
+      size_t row = 0;
+      for (; row + 4 <= size(); row += 4) {
+         const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_last_name_prefix8.data() + row));
+         const __m256i eq = _mm256_cmpeq_epi64(_mm256_and_si256(v, mask_v), needle_v);
+         const unsigned match = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+         n += emit_matches(match, row, out + n);
+      }
+      return n + filter_prefix8_scalar(needle, mask, out + n, row);
+   }
+
+   std::vector<int64_t> m_no;
+   std::vector<uint64_t> m_last_name_prefix8;
+   std::vector<uint32_t> m_first_name_offsets;
+   std::vector<uint32_t> m_last_name_offsets;
+   std::vector<char> m_first_name_arena;
+   std::vector<char> m_last_name_arena;
+};
+void testing_customer_table()
+{
+   {
+      CustomerTable table;
+      for (const Customer& c : std::vector<Customer>{
+            {"Max", "Mustermann", 42}, {"Bob", "Smith", 1}, {"Peter", "Pan", 9}, {"Ellen", "Pan", 11},
+            {"Ellen", "Pan", 22}, {"Paul", "Panther-Schwarzenegger", 12}, {"Paul", "Potz", 10}}) {
+         table.push_back(c);
+      }
+      CustomerTable::selection_t sel;
+      table.filter_no_range(9, 12, sel);
+      cout << "no in [9,12]:            ";
+      for (auto row : sel) cout << table.row(row) << " ";
+      sel.clear();
+      table.filter_last_name_prefix("Pan", sel);
+      cout << "\nlast name \"Pan...\":      ";
+      for (auto row : sel) cout << table.row(row) << " ";
+      sel.clear();
+      table.filter_last_name_prefix("Panther-S", sel);
+      cout << "\nlast name \"Panther-S...\":";
+      for (auto row : sel) cout << " " << table.row(row);
+      cout << "\n";
+   }
+   cout << "–––\n";
+
+   const size_t N = 10000000;
+   const std::vector<Customer> customers = make_customers(N);
+   CustomerTable table;
+   table.reserve(N, 8*N);
+   for (const auto& c : customers) {
+      table.push_back(c);
+   }
+   cout << "memory: vector<Customer> " << customers.capacity()*sizeof(Customer)/1000000 << " MB (SSO names, no heap), "
+        << "CustomerTable " << table.bytes()/1000000 << " MB\n";
+   cout << "AVX2: " << (cpu_has_avx2() ? "yes" : "no") << "\n";
+
+   // 1% of the rows by 'no' (the numbers are a permutation of 0..N-1), ~6% by prefix
+   const long lo = N/4, hi = N/4 + N/100 - 1;
+   const std::string prefix = "Ka";
+   CustomerTable::selection_t sel;
+   sel.reserve(N);
+   bench_harness bench(1, 10);
+   auto run = [&](const std::string& name, auto filter) {
+      const auto st = bench.measure([&]{ sel.clear(); filter(); do_not_optimize(sel.data()); });
+      cout << std::left << std::setw(48) << name << std::right << " matches: " << std::setw(8) << sel.size()
+           << "  median: " << std::setw(7) << st.median/1000 << " us  ns/row: " << (double) st.median/N << "\n";
+   };
+   run("vector<Customer>: no in range", [&]{
+      for (size_t row = 0; row < customers.size(); ++row) {
+         if (customers[row].no >= lo && customers[row].no <= hi) sel.push_back(row);
+      }
+   });
+   run("CustomerTable: no in range (scalar)", [&]{
+      sel.resize(N);
+      sel.resize(table.filter_no_range_scalar(lo, hi, sel.data(), 0));
+   });
+   run("CustomerTable: no in range", [&]{ table.filter_no_range(lo, hi, sel); });
+   run("vector<Customer>: last name prefix", [&]{
+      for (size_t row = 0; row < customers.size(); ++row) {
+         if (customers[row].last_name.compare(0, prefix.size(), prefix) == 0) sel.push_back(row);
+      }
+   });
+   run("CustomerTable: last name prefix (string_view)", [&]{
+      for (size_t row = 0; row < table.size(); ++row) {
+         if (table.last_name(row).substr(0, prefix.size()) == prefix) sel.push_back(row);
+      }
+   });
+   run("CustomerTable: last name prefix", [&]{ table.filter_last_name_prefix(prefix, sel); });
+}
+
+// for 'testing_multi_key_sort'
+/*
+   multi-key sort: order by several keys (e.g. last name, then first name, then no), stable
+   - LSD (least significant digit first) over the keys: sort stably by the last key, then by the one before, ...
+     => after the pass for the first key, ties in it are still ordered by the following keys
+   - every key becomes a 64-bit integer radix key, sorted with a stable LSD radix sort (8 bits per pass):
+      - integral keys: the value with the sign bit flipped (=> unsigned order == signed order)
+      - string keys: the first 8 bytes big-endian, zero padded (=> unsigned order == lexicographic order of the prefixes);
+        runs of equal prefixes that are not decided by the prefix (a string longer than 8 bytes) are
+        ordered by the next 8 bytes, and so on (MSD), only on the compact keys of the run
+        (runs with a '\0' in a string, which compares equal to the padding, by whole-string comparison)
+   - passes whose digit is the same for all keys are skipped (e.g. the upper 5 bytes of a 'no' < 2^24)
+   - parallel: the input is split into n_threads chunks, each sorted as above, then the chunks are merged
+     pairwise (std::merge is stable: on ties it takes from the first, i.e. earlier, chunk)
+   - the projections return either an integral type or something convertible to std::string_view
+*/
+struct radix_key_row {
+   uint64_t key;
+   uint32_t row;
+   uint32_t undecided;   // string keys: the 8 bytes do not decide the order (see 'string_radix_key')
+};
+// stable LSD radix sort by key, all 8 digit histograms are counted in one pass
+inline void radix_sort_by_key(std::vector<radix_key_row>& a, std::vector<radix_key_row>& tmp)
+{
+   const size_t n = a.size();
+   if (n == 0) return;
+   std::vector<std::array<size_t,256>> counts(8);
+   for (auto& c : counts) c.fill(0);
+   for (const auto& e : a) {
+      for (int d = 0; d < 8; ++d) {
+         ++counts[d][(e.key >> 8*d) & 0xff];
+      }
+   }
+   tmp.resize(n);
+   for (int d = 0; d < 8; ++d) {
+      auto& count = counts[d];
+      if (count[(a[0].key >> 8*d) & 0xff] == n) continue;   // same digit everywhere
+      size_t sum = 0;
+      for (auto& c : count) {
+         const size_t cnt = c;
+         c = sum;
+         sum += cnt;
+      }
+      for (const auto& e : a) {
+         tmp[count[(e.key >> 8*d) & 0xff]++] = e;
+      }
+      a.swap(tmp);
+   }
+}
+template <typename K>
+inline int compare_key(const K& k1, const K& k2)
+{
+   if constexpr (std::is_integral<K>::value) {
+      return (k1 > k2) - (k1 < k2);
+   } else {
+      return std::string_view(k1).compare(std::string_view(k2));
+   }
+}
+// lexicographic comparison over all projections
+template <typename T, typename Proj, typename... Projs>
+inline int compare_by(const T& t1, const T& t2, const Proj& proj, const Projs&... projs)
+{
+   const int c = compare_key(proj(t1), proj(t2));
+   if constexpr (sizeof...(Projs) == 0) {
+      return c;
+   } else {
+      return c != 0 ? c : compare_by(t1, t2, projs...);
+   }
+}
+// radix key of the 8 bytes of s at offset, big-endian, zero padded
+// undecided: 0 no more bytes, 1 the string is longer, 2 contains '\0' (same as the zero padding)
+inline radix_key_row string_radix_key(std::string_view s, size_t offset)
+{
+   if (offset >= s.size()) return {0, 0, 0};   // s.data() + offset may not even be formed
+   uint64_t key = 0;
+   const size_t n = std::min<size_t>(s.size() - offset, 8);
+   memcpy(&key, s.data() + offset, n);
+   const uint32_t undecided = memchr(s.data() + offset, '\0', n) ? 2 : s.size() > offset + 8 ? 1 : 0;
+   return {__builtin_bswap64(key), 0, undecided};
+}
+// keys[first,last) have the same radix key for the string bytes [0, offset): orders them by the following bytes
+// (MSD, 8 bytes per level), runs with a '\0' in a string are sorted by whole-string comparison
+template <typename T, typename Proj>
+void refine_string_run(const std::vector<T>& v, const Proj& proj, std::vector<radix_key_row>& keys,
+                       size_t first, size_t last, size_t offset)
+{
+   const auto key_less = [](const radix_key_row& k1, const radix_key_row& k2) { return k1.key < k2.key; };
+   bool has_nul = false;
+   for (size_t i = first; i < last; ++i) {
+      has_nul |= keys[i].undecided == 2;
+   }
+   if (has_nul) {
+      std::stable_sort(keys.begin() + first, keys.begin() + last, [&](const radix_key_row& k1, const radix_key_row& k2) {
+         return compare_key(proj(v[k1.row]), proj(v[k2.row])) < 0;
+      });
+      return;
+   }
+   for (size_t i = first; i < last; ++i) {
+      const uint32_t row = keys[i].row;
+      keys[i] = string_radix_key(proj(v[row]), offset);
+      keys[i].row = row;
+   }
+   std::stable_sort(keys.begin() + first, keys.begin() + last, key_less);
+   for (size_t b = first; b < last; ) {
+      size_t e = b + 1;
+      bool undecided = keys[b].undecided;
+      for (; e < last && keys[e].key == keys[b].key; ++e) {
+         undecided |= keys[e].undecided;
+      }
+      if (e - b > 1 && undecided) {
+         refine_string_run(v, proj, keys, b, e, offset + 8);
+      }
+      b = e;
+   }
+}
+// one stable LSD pass: reorders 'order' (the rows first_row, first_row+1, ... in some order) by the key proj(v[row])
+template <typename T, typename Proj>
+void multi_key_sort_pass(const std::vector<T>& v, size_t first_row, std::vector<uint32_t>& order, const Proj& proj,
+                         std::vector<radix_key_row>& keys, std::vector<radix_key_row>& tmp)
+{
+   using K = std::decay_t<decltype(proj(v[0]))>;
+   // the radix keys are computed in row order (a sequential scan over v), then gathered in the current order
+   // from this compact array instead of from the records
+   tmp.resize(order.size());
+   for (size_t i = 0; i < order.size(); ++i) {
+      const auto& k = proj(v[first_row + i]);
+      if constexpr (std::is_integral<K>::value) {
+         tmp[i].key = (uint64_t) (int64_t) k ^ (std::is_signed<K>::value ? 1ULL << 63 : 0);
+         tmp[i].undecided = 0;
+      } else {
+         tmp[i] = string_radix_key(k, 0);
+      }
+   }
+   keys.resize(order.size());
+   for (size_t i = 0; i < order.size(); ++i) {
+      const auto& k = tmp[order[i] - first_row];
+      keys[i] = {k.key, order[i], k.undecided};
+   }
+   radix_sort_by_key(keys, tmp);
+   if constexpr (!std::is_integral<K>::value) {
+      for (size_t first = 0; first < keys.size(); ) {
+         size_t last = first + 1;
+         bool undecided = keys[first].undecided;
+         for (; last < keys.size() && keys[last].key == keys[first].key; ++last) {
+            undecided |= keys[last].undecided;
+         }
+         if (last - first > 1 && undecided) {
+            refine_string_run(v, proj, keys, first, last, 8);
+         }
+         first = last;
+      }
+   }
+   for (size_t i = 0; i < keys.size(); ++i) {
+      order[i] = keys[i].row;
+   }
+}
+// LSD over the keys: the pass for the last key first
+template <typename T, typename Proj, typename... Projs>
+void multi_key_sort_passes(const std::vector<T>& v, size_t first_row, std::vector<uint32_t>& order,
+                           std::vector<radix_key_row>& keys, std::vector<radix_key_row>& tmp,
+                           const Proj& proj, const Projs&... projs)
+{
+   if constexpr (sizeof...(Projs) > 0) {
+      multi_key_sort_passes(v, first_row, order, keys, tmp, projs...);
+   }
+   multi_key_sort_pass(v, first_row, order, proj, keys, tmp);
+}
+// permutation that sorts v by (projs...), stable
+template <typename T, typename... Projs>
+std::vector<uint32_t> multi_key_sort_order(const std::vector<T>& v, unsigned n_threads, const Projs&... projs)
+{
+   if (v.size() > std::numeric_limits<uint32_t>::max()) throw std::length_error("multi_key_sort: too many elements");
+   n_threads = std::max(1u, std::min<unsigned>(n_threads, v.size()/100000 + 1));
+   std::vector<uint32_t> order(v.size());
+   std::iota(order.begin(), order.end(), 0);
+   std::vector<size_t> bounds;
+   for (size_t i = 0; i <= n_threads; ++i) {
+      bounds.push_back(v.size()*i/n_threads);
+   }
+   auto sort_chunk = [&](size_t b, size_t e) {
+      std::vector<uint32_t> chunk(order.begin() + b, order.begin() + e);
+      std::vector<radix_key_row> keys, tmp;
+      multi_key_sort_passes(v, b, chunk, keys, tmp, projs...);
+      std::copy(chunk.begin(), chunk.end(), order.begin() + b);
+   };
+   std::vector<std::future<void>> tasks;
+   for (size_t i = 0; i < n_threads; ++i) {
+      tasks.push_back(std::async(std::launch::async, sort_chunk, bounds[i], bounds[i+1]));
+   }
+   for (auto& t : tasks) t.get();
+
+   // merge phase
+   auto less = [&](uint32_t r1, uint32_t r2) { return compare_by(v[r1], v[r2], projs...) < 0; };
+   std::vector<uint32_t> merged(order.size());
+   for (size_t width = 1; width < n_threads; width *= 2) {
+      tasks.clear();
+      for (size_t i = 0; i < n_threads; i += 2*width) {
+         const size_t lo = bounds[i];
+         const size_t mid = bounds[std::min<size_t>(i + width, n_threads)];
+         const size_t hi = bounds[std::min<size_t>(i + 2*width, n_threads)];
+         tasks.push_back(std::async(std::launch::async, [&, lo, mid, hi]{
+            std::merge(order.begin()+lo, order.begin()+mid, order.begin()+mid, order.begin()+hi, merged.begin()+lo, less);
+         }));
+      }
+      for (auto& t : tasks) t.get();
+      order.swap(merged);
+   }
+   return order;
+}
+// sorts v by (projs...), stable
+template <typename T, typename... Projs>
+void multi_key_sort(std::vector<T>& v, unsigned n_threads, const Projs&... projs)
+{
+   const std::vector<uint32_t> order = multi_key_sort_order(v, n_threads, projs...);
+   std::vector<T> sorted;
+   sorted.reserve(v.size());
+   for (const auto row : order) {
+      sorted.push_back(std::move(v[row]));
+   }
+   v.swap(sorted);
+}
+void testing_multi_key_sort()
+{
+   std::vector<Customer> customers = {
+      {"Max",  "Mustermann", 42}, {"Bob",  "Smith",       1}, {"Anna", "Black",       2},
+      {"Jack", "Smith",       5}, {"Jane", "Doe",        19}, {"Zulu", "Akebe",       7},
+      {"Greg", "Doherty",    33}, {"Paul", "Walker",      8}, {"Peter", "Pan",        9},
+      {"Paul", "Potz",       10}, {"Ellen", "Pan",       22}, {"Ellen", "Pan",       11},
+      {"Ellen", "Panther-Schwarzenegger", 3}, {"Anna", "Panther-Schwarz", 4}
+   };
+   multi_key_sort(customers, 1, Customer_by_lastName(), Customer_by_firstName(), Customer_by_customerNo());
+   cout << "customers sorted by last name, first name, no.:\n";
+   for (const auto& c : customers) {
+      cout << "  " << c.last_name << "," << c.first_name << "," << c.no << "\n";
+   }
+   cout << "–––\n";
+
+   const size_t N = 10000000;
+   const std::vector<Customer> input = make_customers(N);
+   const unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+   auto less = [](const Customer& c1, const Customer& c2) {
+      return compare_by(c1, c2, Customer_by_lastName(), Customer_by_firstName(), Customer_by_customerNo()) < 0;
+   };
+   std::vector<Customer> v1, v2;
+   bench_harness bench(0, 3);
+   bench_harness::print_stats(cout, "std::stable_sort, composite comparator, 10M customers",
+      bench.measure([&]{ std::stable_sort(v1.begin(), v1.end(), less); },
+                    [&]{ v1.clear(); v1.shrink_to_fit(); v1 = input; }), N);
+   bench_harness::print_stats(cout, "multi_key_sort, " + std::to_string(n_threads) + " thread(s), 10M customers",
+      bench.measure([&]{
+         multi_key_sort(v2, n_threads, Customer_by_lastName(), Customer_by_firstName(), Customer_by_customerNo());
+      }, [&]{ v2.clear(); v2.shrink_to_fit(); v2 = input; }), N);
+   bench_harness::print_stats(cout, "multi_key_sort_order (permutation only), 10M customers",
+      bench.measure([&]{
+         do_not_optimize(multi_key_sort_order(input, n_threads, Customer_by_lastName(), Customer_by_firstName(), Customer_by_customerNo()).data());
+      }), N);
+   bool same = true;
+   for (size_t i = 0; i < N && same; ++i) {
+      same = v1[i].no == v2[i].no;
+   }
+   cout << "same order as std::stable_sort: " << std::boolalpha << same << std::noboolalpha << "\n";
+}
+
+// for 'testing_processing_adjacent_elements'
+/*
+   run_boundaries(data, n, boundaries): the runs of equal values in data[0,n), as in 'indices' of
+   'testing_processing_adjacent_elements': boundaries == 0, <start of every further run>, n
+   => the runs are the half-open ranges [boundaries[i], boundaries[i+1])
+   - vectorized: compare W lanes with their left neighbours (an unaligned load shifted by one element),
+     the mismatch mask has a bit per byte (movemask_epi8), collapsed to one bit per element,
+     the set bits are the run starts (tzcnt loop)
+   - byte-wise compare => integral (and enum) types only, where equality is bitwise equality
+   - AVX2 (32 bytes per compare) if the CPU has it, else SSE2 (16 bytes)
+*/
+template <typename T>
+void run_boundaries_scalar(const T* data, size_t first, size_t n, std::vector<size_t>& boundaries)
+{
+   for (size_t i = std::max<size_t>(first, 1); i < n; ++i) {
+      if (data[i] != data[i-1]) boundaries.push_back(i);
+   }
+}
+// one bit (the lowest of its bytes) per element of size 'elem_size'
+inline uint32_t collapse_byte_mask(uint32_t byte_mask, size_t elem_size)
+{
+   switch (elem_size) {
+      case 1: return byte_mask;
+      case 2: return (byte_mask | (byte_mask >> 1)) & 0x55555555u;
+      case 4: byte_mask |= byte_mask >> 1; byte_mask |= byte_mask >> 2; return byte_mask & 0x11111111u;
+      default: byte_mask |= byte_mask >> 1; byte_mask |= byte_mask >> 2; byte_mask |= byte_mask >> 4; return byte_mask & 0x01010101u;
+   }
+}
+// bit k of mask set => boundary at element base + k/sizeof(T)
+template <typename T>
+inline void emit_boundaries(uint32_t mask, size_t base, std::vector<size_t>& boundaries)
+{
+   while (mask) {
+      boundaries.push_back(base + __builtin_ctz(mask)/sizeof(T));
+      mask &= mask-1;
+   }
+}
+template <typename T>
+void run_boundaries_sse2(const T* data, size_t n, std::vector<size_t>& boundaries)
+{
+   constexpr size_t W = 16/sizeof(T);
+   size_t i = 1;
+   for (; i + W <= n; i += W) {
+      const __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i - 1));
+      const uint32_t mismatch = ~_mm_movemask_epi8(_mm_cmpeq_epi8(cur, prev)) & 0xffffu;
+      if (mismatch) emit_boundaries<T>(collapse_byte_mask(mismatch, sizeof(T)), i, boundaries);
+   }
+   run_boundaries_scalar(data, i, n, boundaries);
+}
+template <typename T>
+__attribute__((target("avx2")))
+void run_boundaries_avx2(const T* data, size_t n, std::vector<size_t>& boundaries)
+{
+   constexpr size_t W = 32/sizeof(T);
+   size_t i = 1;
+   for (; i + W <= n; i += W) {
+      const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i - 1));
+      const uint32_t mismatch = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(cur, prev));
+      if (mismatch) emit_boundaries<T>(collapse_byte_mask(mismatch, sizeof(T)), i, boundaries);
+   }
+   run_boundaries_scalar(data, i, n, boundaries);
+}
+template <typename T>
+void run_boundaries(const T* data, size_t n, std::vector<size_t>& boundaries)
+{
+   static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "run_boundaries: bitwise comparable types only");
+   static_assert(sizeof(T) <= 8, "run_boundaries: elements of up to 8 bytes");
+   boundaries.clear();
+   boundaries.push_back(0);
+   if (n == 0) return;
+   if (cpu_has_avx2()) {
+      run_boundaries_avx2(data, n, boundaries);
+   } else {
+      run_boundaries_sse2(data, n, boundaries);
+   }
+   boundaries.push_back(n);
+}
+template <typename T>
+std::vector<size_t> run_boundaries(const std::vector<T>& v)
+{
+   std::vector<size_t> boundaries;
+   run_boundaries(v.data(), v.size(), boundaries);
+   return boundaries;
+}
+// the [a,b) ranges themselves
+inline std::vector<std::pair<size_t,size_t>> run_ranges(const std::vector<size_t>& boundaries)
+{
+   std::vector<std::pair<size_t,size_t>> ranges;
+   for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+      ranges.emplace_back(boundaries[i], boundaries[i+1]);
+   }
+   return ranges;
+}
+void testing_processing_adjacent_elements()
+{
+   // p.437
+   //int arr[] = { 1,1,1,2,2,3,4,4,4,4,5,6,6 };
+   int arr[] = { 1,1,1,2,2,3,4,4,4,4,5,6,6,99 };
+   //int arr[] = { 1,1 };
+   //int arr[] = { 1,2 };
+   //int arr[] = { 1,1,1 };
+   //int arr[] = { 1,2,3 };
+
+   int *pos, *pos_ahead, *end;
+   pos = pos_ahead = arr;
+   const int n_elems = sizeof(arr)/sizeof(arr[0]);
+   end = &arr[n_elems];
+   
+   auto print_arr = [&arr]() {
+      cout << "arr (vals): ";
+      for (const auto& e : arr) { cout << std::setw(2) << e << " "; }
+      cout << "\n";
+      
+      cout << "arr (idxs): ";
+      for (size_t i=0; i < std::size(arr); ++i) { cout << std::setw(2) << i << " "; }
+      cout << "\n";
    };
 
    print_arr();   
@@ -3432,13 +6214,62 @@ void testing_processing_adjacent_elements()
          }
       }
    }
+   {
+      // vectorized (see 'run_boundaries')
+      cout << "–––\n";
+      std::vector<size_t> boundaries;
+      run_boundaries(arr, n_elems, boundaries);
+      print_elements(boundaries, "run_boundaries: ");
+      for (const auto& [a,b] : run_ranges(boundaries)) {
+         cout << "[" << std::setw(2) << a << "," << std::setw(2) << b << "): " << arr[a] << " x" << (b-a) << "\n";
+      }
+   }
+}
+// group-by on a sorted column: throughput of run_boundaries on 1 GiB
+void testing_run_boundaries_bench()
+{
+   const size_t n_bytes = 1UL << 30;
+   auto bench_type = [&](const std::string& type_name, auto zero) {
+      using T = decltype(zero);
+      const size_t n = n_bytes/sizeof(T);
+      std::vector<T, default_init_allocator<T>> v(n);
+      for (const double mean_run_length : {1e6, 1000.0, 16.0}) {
+         // sorted input: non-decreasing, a new value with probability 1/mean_run_length
+         std::mt19937_64 engine(1);
+         std::bernoulli_distribution new_value(1.0/mean_run_length);
+         T val = 0;
+         for (size_t i = 0; i < n; ++i) {
+            val += new_value(engine);
+            v[i] = val;
+         }
+         std::vector<size_t> boundaries;
+         boundaries.reserve(2*n/mean_run_length + 1024);
+         bench_harness bench(1, 5);
+         auto run = [&](const std::string& name, auto fn) {
+            const auto st = bench.measure([&]{ boundaries.clear(); fn(); });
+            cout << std::left << std::setw(8) << type_name << std::setw(8) << name << std::right
+                 << " mean run length " << std::setw(7) << mean_run_length
+                 << "  runs: " << std::setw(10) << boundaries.size()-1
+                 << "  " << std::setw(6) << std::fixed << std::setprecision(2) << (double) n_bytes/st.median << " GB/s\n";
+            cout << std::defaultfloat << std::setprecision(6);
+         };
+         run("scalar", [&]{ boundaries.push_back(0); run_boundaries_scalar(v.data(), 1, n, boundaries); boundaries.push_back(n); });
+         run("SSE2", [&]{ boundaries.push_back(0); run_boundaries_sse2(v.data(), n, boundaries); boundaries.push_back(n); });
+         if (cpu_has_avx2()) {
+            run("AVX2", [&]{ boundaries.push_back(0); run_boundaries_avx2(v.data(), n, boundaries); boundaries.push_back(n); });
+         }
+      }
+   };
+   bench_type("int32", int32_t());
+   bench_type("int64", int64_t());
+   bench_type("uint8", uint8_t());
 }
 
 // for 'testing_shift_left'
-// precondition: ForwardIterator NEEDS to have public typedef/using of 'value_type'
+// element by element, for any ForwardIterator (value_type via iterator_traits, so raw pointers work as well)
 template<typename ForwardIterator>
-void shift_left(ForwardIterator beg, ForwardIterator end) {
-   using value_type = typename ForwardIterator::value_type;
+void shift_left_elementwise(ForwardIterator beg, ForwardIterator end) {
+   using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
    if (beg != end) {
       // save val of 1st elem
       value_type tmp(*beg);
@@ -3454,6 +6285,80 @@ void shift_left(ForwardIterator beg, ForwardIterator end) {
       }
    }
 }
+/*
+   contiguous iterators: C++17 has no contiguous_iterator_tag (C++20),
+   so only raw pointers (incl. std::array<T,N>::iterator in libstdc++) and std::vector<T>::iterator are detected
+   (std::vector<bool>::iterator is not contiguous)
+*/
+template <typename It>
+struct is_contiguous_iterator : std::integral_constant<bool,
+   std::is_pointer<It>::value ||
+   (!std::is_same<typename std::iterator_traits<It>::value_type, bool>::value &&
+    (std::is_same<It, typename std::vector<typename std::iterator_traits<It>::value_type>::iterator>::value ||
+     std::is_same<It, typename std::vector<typename std::iterator_traits<It>::value_type>::const_iterator>::value))> {};
+// ... and writable: *it is a non-const lvalue (not a const_iterator / const T*)
+template <typename It>
+constexpr bool is_memmovable_range =
+   is_contiguous_iterator<It>::value &&
+   std::is_trivially_copyable<typename std::iterator_traits<It>::value_type>::value &&
+   std::is_lvalue_reference<decltype(*std::declval<It>())>::value &&
+   !std::is_const<std::remove_reference_t<decltype(*std::declval<It>())>>::value;
+/*
+   shift_left (p.468): [a,b,c,d] -> [b,c,d,a]
+   - contiguous + trivially copyable: save the 1st element, 1 memmove of the rest, store the saved element
+   - otherwise: element by element
+*/
+template<typename ForwardIterator>
+void shift_left(ForwardIterator beg, ForwardIterator end) {
+   using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+   if constexpr (is_memmovable_range<ForwardIterator>) {
+      const size_t n = end - beg;
+      if (n > 1) {
+         value_type* p = std::addressof(*beg);
+         const value_type tmp = p[0];
+         memmove(p, p + 1, (n-1)*sizeof(value_type));
+         p[n-1] = tmp;
+      }
+   } else {
+      shift_left_elementwise(beg, end);
+   }
+}
+/*
+   rotate_left_by(beg, end, k): shift_left k times, i.e. std::rotate(beg, beg+k, end), k may be >= the size
+   - contiguous + trivially copyable: the smaller of the two parts goes through a buffer
+     => 2 memcpy + 1 memmove, every element read and written at most twice (std::rotate on random access
+        iterators uses the cycle/swap algorithm instead, no buffer)
+   - otherwise: std::rotate
+*/
+template<typename ForwardIterator>
+void rotate_left_by(ForwardIterator beg, ForwardIterator end, size_t k) {
+   using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+   const size_t n = std::distance(beg, end);
+   if (n < 2 || (k %= n) == 0) {
+      return;
+   }
+   if constexpr (is_memmovable_range<ForwardIterator>) {
+      value_type* p = std::addressof(*beg);
+      if (k == 1) {
+         shift_left(beg, end);
+      } else if (k <= n-k) {
+         // buffer the first k elements, move the other n-k to the front
+         // raw bytes: value_type needs no default ctor, nothing is constructed
+         std::unique_ptr<unsigned char[]> buf(new unsigned char[k*sizeof(value_type)]);
+         memcpy(buf.get(), p, k*sizeof(value_type));
+         memmove(p, p + k, (n-k)*sizeof(value_type));
+         memcpy(p + (n-k), buf.get(), k*sizeof(value_type));
+      } else {
+         // buffer the last n-k elements, move the first k to the back
+         std::unique_ptr<unsigned char[]> buf(new unsigned char[(n-k)*sizeof(value_type)]);
+         memcpy(buf.get(), p + k, (n-k)*sizeof(value_type));
+         memmove(p + (n-k), p, k*sizeof(value_type));
+         memcpy(p, buf.get(), (n-k)*sizeof(value_type));
+      }
+   } else {
+      std::rotate(beg, std::next(beg, k), end);
+   }
+}
 void testing_shift_left()
 {
    // p.468
@@ -3469,12 +6374,59 @@ void testing_shift_left()
       shift_left(v.begin(), v.end());
       print_elements(v, "v after shift_left: ");
    }
-}
-
-void testing_nth_element()
-{
-   // nth_element() vs. partial_sort()
-   /*
+   {
+      // raw pointers (no nested value_type), and non-trivially copyable elements
+      std::array<int,6> arr = { 0,1,2,3,4,5 };
+      shift_left(arr.data(), arr.data() + arr.size());
+      print_elements(arr, "arr after shift_left(int*,int*): ");
+      std::list<std::string> l = { "a","b","c","d" };
+      shift_left(l.begin(), l.end());
+      print_elements(l, "list after shift_left: ");
+      std::vector<int> v = { 0,1,2,3,4,5,6,7 };
+      rotate_left_by(v.begin(), v.end(), 3);
+      print_elements(v, "v after rotate_left_by(3): ");
+      rotate_left_by(v.begin(), v.end(), 7);
+      print_elements(v, "v after rotate_left_by(7): ");
+   }
+   {
+      // trivially copyable without a default ctor: memmove path, the buffer is raw bytes
+      struct Point { Point(int x, int y) : x(x), y(y) {} int x, y; };
+      std::vector<Point> points = { {0,0}, {1,1}, {2,2}, {3,3}, {4,4} };
+      rotate_left_by(points.begin(), points.end(), 2);
+      cout << "points after rotate_left_by(2): ";
+      for (const auto& pt : points) cout << "(" << pt.x << "," << pt.y << ") ";
+      cout << "\n";
+      // const ranges are never written through a memmove
+      static_assert(is_memmovable_range<int*> && is_memmovable_range<std::vector<int>::iterator>, "writable ranges");
+      static_assert(!is_memmovable_range<const int*> && !is_memmovable_range<std::vector<int>::const_iterator>,
+                    "const ranges");
+   }
+   {
+      // 64 MiB of ints
+      // with -O2 gcc recognizes the element loop of ints as a memmove (-ftree-loop-distribute-patterns),
+      // so the difference shows with -O0 or for types/iterators the compiler can't see through
+      cout << "–––\n";
+      const size_t N = (64UL << 20)/sizeof(int);
+      std::vector<int> v(N);
+      std::iota(v.begin(), v.end(), 0);
+      bench_harness bench(1, 10);
+      auto run = [&](const std::string& name, auto fn) {
+         bench_harness::print_stats(cout, name, bench.measure(fn));
+      };
+      run("shift_left (element loop), 64 MiB",   [&]{ shift_left_elementwise(v.begin(), v.end()); });
+      run("shift_left (memmove), 64 MiB",        [&]{ shift_left(v.begin(), v.end()); });
+      run("std::rotate(beg, beg+1, end), 64 MiB", [&]{ std::rotate(v.begin(), v.begin()+1, v.end()); });
+      for (const size_t k : {1000UL, N/3}) {
+         run("rotate_left_by(" + std::to_string(k) + "), 64 MiB", [&]{ rotate_left_by(v.begin(), v.end(), k); });
+         run("std::rotate(beg, beg+" + std::to_string(k) + ", end), 64 MiB", [&]{ std::rotate(v.begin(), v.begin()+k, v.end()); });
+      }
+   }
+}
+
+void testing_nth_element()
+{
+   // nth_element() vs. partial_sort()
+   /*
       performance of nth_element() vs. partial_sort()
       when finding the first 2 smallest/largest elems in a sequence ?
       => nth_element() should be better as less work is done here, see p.514-515
@@ -3527,19 +6479,281 @@ void testing_nth_element()
    }
 }
 
+// for 'testing_top_k'
+/*
+   top_k<T,Compare>: the k first elements (in Compare order: with std::less the k smallest) of a stream
+   of unknown length, in O(k + buffer) memory
+   - HEAP: a heap of the k best so far, whose top is the worst of them (the threshold):
+     a new value either fails one comparison against the threshold, or replaces the top (O(log k))
+   - NTH_ELEMENT: values are appended to a buffer of 'batch' elements (at least 2k and 1024, a buffer
+     of about k would compact on every push => O(k) per value), when full nth_element()
+     keeps the k best (O(buffer) per batch, p.514) and the k-th best becomes the threshold,
+     which rejects later values with one comparison before they get buffered
+   - PARTIAL_SORT: as NTH_ELEMENT, but partial_sort() to compact the buffer (O(buffer log k))
+   - merge(): combines the partial result of another top_k (e.g. one per thread)
+   - result(): the k best, sorted
+*/
+enum class TOPK_STRATEGY { HEAP, NTH_ELEMENT, PARTIAL_SORT };
+template <typename T, typename Compare = std::less<T>>
+class top_k {
+public:
+   explicit top_k(size_t k, TOPK_STRATEGY strategy = TOPK_STRATEGY::HEAP, Compare comp = Compare(), size_t batch = 0)
+      : m_k(k), m_strategy(strategy), m_comp(comp), m_batch(std::max<size_t>({batch ? batch : 4*k, 2*k, 1024}))
+   {
+      m_buf.reserve(m_strategy == TOPK_STRATEGY::HEAP ? k : m_batch);
+   }
 
-template <int N>
-struct factorial_helper {
-   static constexpr long val = N*factorial_helper<N-1>::val;
+   void push(const T& val) {
+      ++m_n_seen;
+      if (m_strategy == TOPK_STRATEGY::HEAP) {
+         push_heap(val);
+      } else {
+         push_buffered(val);
+      }
+   }
+   // the strategy is dispatched once per range, not per value
+   template <typename InputIt>
+   void push(InputIt first, InputIt last) {
+      if (m_strategy == TOPK_STRATEGY::HEAP) {
+         for (; first != last; ++first, ++m_n_seen) push_heap(*first);
+      } else {
+         for (; first != last; ++first, ++m_n_seen) push_buffered(*first);
+      }
+   }
+   void merge(const top_k& other) {
+      const size_t n_seen = m_n_seen + other.m_n_seen;
+      for (const auto& val : other.result()) push(val);
+      m_n_seen = n_seen;
+   }
+   std::vector<T> result() const {
+      std::vector<T> res(m_buf);
+      if (m_strategy == TOPK_STRATEGY::HEAP) {
+         std::sort_heap(res.begin(), res.end(), m_comp);
+      } else {
+         const size_t n = std::min(m_k, res.size());
+         std::partial_sort(res.begin(), res.begin() + n, res.end(), m_comp);
+         res.resize(n);
+      }
+      return res;
+   }
+   size_t k() const { return m_k; }
+   size_t n_seen() const { return m_n_seen; }
+
+private:
+   void push_heap(const T& val) {
+      if (m_buf.size() < m_k) {
+         m_buf.push_back(val);
+         std::push_heap(m_buf.begin(), m_buf.end(), m_comp);
+      } else if (m_k > 0 && m_comp(val, m_buf.front())) {
+         // replace the worst of the k best
+         std::pop_heap(m_buf.begin(), m_buf.end(), m_comp);
+         m_buf.back() = val;
+         std::push_heap(m_buf.begin(), m_buf.end(), m_comp);
+      }
+   }
+   void push_buffered(const T& val) {
+      if (m_has_threshold && !m_comp(val, m_threshold)) return;
+      if (m_k == 0) return;
+      m_buf.push_back(val);
+      if (m_buf.size() >= m_batch) compact();
+   }
+   // keep the k best of the buffer, the k-th best is the new threshold
+   void compact() {
+      if (m_buf.size() <= m_k) return;
+      if (m_strategy == TOPK_STRATEGY::NTH_ELEMENT) {
+         std::nth_element(m_buf.begin(), m_buf.begin() + (m_k-1), m_buf.end(), m_comp);
+         m_threshold = m_buf[m_k-1];
+      } else {
+         std::partial_sort(m_buf.begin(), m_buf.begin() + m_k, m_buf.end(), m_comp);
+         m_threshold = m_buf[m_k-1];
+      }
+      m_buf.resize(m_k);
+      m_has_threshold = true;
+   }
+
+   size_t m_k;
+   TOPK_STRATEGY m_strategy;
+   Compare m_comp;
+   size_t m_batch;
+   std::vector<T> m_buf;
+   T m_threshold{};
+   bool m_has_threshold = false;
+   size_t m_n_seen = 0;
 };
-template <>
-struct factorial_helper<1> {
-   static constexpr long val = 1;
+// stream source for the benchmark: splitmix64, cheaper than mt19937 so the generator doesn't dominate
+inline uint64_t splitmix64_mix(uint64_t z) {
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}
+struct splitmix64_stream {
+   uint64_t state;
+   uint64_t operator()() {
+      return splitmix64_mix(state += 0x9e3779b97f4a7c15ULL);
+   }
 };
+void testing_top_k()
+{
+   {
+      // custom comparator: the 3 largest metrics
+      struct Metric { std::string name; double value; };
+      auto by_value_desc = [](const Metric& m1, const Metric& m2) { return m1.value > m2.value; };
+      top_k<Metric, decltype(by_value_desc)> top3(3, TOPK_STRATEGY::HEAP, by_value_desc);
+      for (const auto& m : std::vector<Metric>{
+            {"cpu", 71.5}, {"mem", 43.0}, {"disk", 99.1}, {"net", 12.9}, {"gpu", 88.0}, {"io", 71.6}}) {
+         top3.push(m);
+      }
+      cout << "top 3 metrics: ";
+      for (const auto& m : top3.result()) cout << m.name << "=" << m.value << " ";
+      cout << "\n";
+   }
+   {
+      // per-thread partial results, merged
+      const size_t N = 10000000;
+      const size_t k = 5;
+      const unsigned n_threads = 4;
+      std::vector<top_k<uint64_t>> partial(n_threads, top_k<uint64_t>(k));
+      std::vector<std::thread> threads;
+      for (unsigned t = 0; t < n_threads; ++t) {
+         threads.emplace_back([&partial, t, N, n_threads]{
+            splitmix64_stream rng{t};
+            for (size_t i = 0; i < N/n_threads; ++i) partial[t].push(rng() >> 20);
+         });
+      }
+      for (auto& th : threads) th.join();
+      top_k<uint64_t> total(k);
+      for (const auto& p : partial) total.merge(p);
+      cout << "5 smallest of " << total.n_seen() << " values from " << n_threads << " threads: ";
+      for (const auto& v : total.result()) cout << v << " ";
+      cout << "\n";
+   }
+   {
+      // a batch smaller than k is raised to 2k
+      const size_t k = 5000;
+      top_k<uint64_t> heap(k), nth(k, TOPK_STRATEGY::NTH_ELEMENT, {}, 100);
+      splitmix64_stream rng{7};
+      for (size_t i = 0; i < 1000000; ++i) {
+         const uint64_t v = rng();
+         heap.push(v);
+         nth.push(v);
+      }
+      cout << "k=5000, batch=100: same result as the heap: " << (heap.result() == nth.result() ? "true" : "false") << "\n";
+   }
+   cout << "–––\n";
+   // sweep: N values streamed in chunks of 4096, all 3 strategies must give the same result
+   const std::pair<TOPK_STRATEGY, const char*> strategies[] = {
+      {TOPK_STRATEGY::HEAP, "heap"}, {TOPK_STRATEGY::NTH_ELEMENT, "nth_element"}, {TOPK_STRATEGY::PARTIAL_SORT, "partial_sort"}
+   };
+   std::vector<uint64_t> chunk(4096);
+   for (const size_t N : {1000000UL, 100000000UL, 1000000000UL}) {
+      {
+         // baseline: generating the stream only
+         splitmix64_stream rng{42};
+         uint64_t sum = 0;
+         const long t0 = nanos();
+         for (size_t i = 0; i < N; i += chunk.size()) {
+            const size_t n = std::min(chunk.size(), N - i);
+            for (size_t j = 0; j < n; ++j) chunk[j] = rng();
+            sum += chunk[0];
+         }
+         const long t1 = nanos();
+         do_not_optimize(sum);
+         cout << "N=" << std::setw(10) << N << "  (generating the stream only)        ns/value: "
+              << std::setw(6) << std::fixed << std::setprecision(2) << (double) (t1-t0)/N << std::defaultfloat << "\n";
+      }
+      for (const size_t k : {10UL, 1000UL, 100000UL}) {
+         std::vector<uint64_t> first_result;
+         for (const auto& [strategy, name] : strategies) {
+            top_k<uint64_t> top(k, strategy);
+            splitmix64_stream rng{42};
+            const long t0 = nanos();
+            for (size_t i = 0; i < N; i += chunk.size()) {
+               const size_t n = std::min(chunk.size(), N - i);
+               for (size_t j = 0; j < n; ++j) chunk[j] = rng();
+               top.push(chunk.begin(), chunk.begin() + n);
+            }
+            const std::vector<uint64_t> res = top.result();
+            const long t1 = nanos();
+            if (first_result.empty()) first_result = res;
+            cout << "N=" << std::setw(10) << N << "  k=" << std::setw(6) << k << "  " << std::left << std::setw(12) << name << std::right
+                 << "  ns/value: " << std::setw(6) << std::fixed << std::setprecision(2) << (double) (t1-t0)/N << std::defaultfloat
+                 << (res == first_result ? "" : "  RESULT DIFFERS") << "\n";
+         }
+      }
+   }
+   cout << std::setprecision(6);
+}
+
+
+// 64-bit factorial, constexpr: 20! = 2432902008176640000 is the largest that fits into uint64_t
+constexpr uint64_t factorial_u64(unsigned n) {
+   uint64_t f = 1;
+   for (unsigned i = 2; i <= n; ++i) {
+      f *= i;
+   }
+   return f;
+}
 template <int N>
 struct factorial {
-   static constexpr long val = factorial_helper<N>::val;
+   static_assert(N >= 0 && N <= 20, "factorial: N! does not fit into 64 bits for N > 20");
+   static constexpr uint64_t val = factorial_u64(N);
 };
+static_assert(factorial<20>::val == 2432902008176640000ULL, "20!");
+/*
+   unranking: the rank-th permutation (0-based, in the lexicographic order of std::next_permutation)
+   of the sorted, distinct elements 'sorted'
+   - factorial number system: rank = d[0]*(n-1)! + d[1]*(n-2)! + ... + d[n-1]*0!, with 0 <= d[i] <= n-1-i
+     => d[i] is the index of the i-th element of the permutation among the elements not used yet
+   - O(n^2), n <= 20
+*/
+template <typename T>
+void unrank_permutation(const std::vector<T>& sorted, uint64_t rank, std::vector<T>& perm)
+{
+   if (sorted.size() > 20) throw std::length_error("unrank_permutation: more than 20 elements");
+   std::vector<T> rest(sorted);
+   perm.clear();
+   for (size_t i = sorted.size(); i > 0; --i) {
+      const uint64_t f = factorial_u64(i-1);
+      const size_t d = rank / f;
+      rank %= f;
+      perm.push_back(rest[d]);
+      rest.erase(rest.begin() + d);
+   }
+}
+/*
+   visits all n! permutations of the sorted, distinct elements 'sorted' with n_threads threads
+   - [0, n!) is split into chunks of ranks, each worker takes the next chunk (atomic counter), unranks its first
+     permutation and continues with std::next_permutation to the end of the chunk
+     => more chunks than threads, so that a slower thread doesn't delay the end
+   - f(perm, thread_idx) is called concurrently, thread_idx for per-thread results
+*/
+template <typename T, typename F>
+void parallel_for_each_permutation(const std::vector<T>& sorted, unsigned n_threads, F f)
+{
+   n_threads = std::max(1u, n_threads);
+   const uint64_t n_perms = factorial_u64(sorted.size());
+   const uint64_t n_chunks = std::min<uint64_t>(n_perms, 64*n_threads);
+   std::atomic<uint64_t> next_chunk{0};
+   // start rank of chunk c (128-bit product, n! * c overflows 64 bits for large n)
+   auto chunk_begin = [&](uint64_t c) { return (uint64_t) ((uint128_t) n_perms * c / n_chunks); };
+   auto worker = [&](unsigned thread_idx) {
+      std::vector<T> perm;
+      for (uint64_t c = next_chunk++; c < n_chunks; c = next_chunk++) {
+         unrank_permutation(sorted, chunk_begin(c), perm);
+         const uint64_t n = chunk_begin(c+1) - chunk_begin(c);
+         for (uint64_t i = 0; i < n; ++i) {
+            f(static_cast<const std::vector<T>&>(perm), thread_idx);
+            std::next_permutation(perm.begin(), perm.end());
+         }
+      }
+   };
+   std::vector<std::thread> threads;
+   for (unsigned t = 1; t < n_threads; ++t) {
+      threads.emplace_back(worker, t);
+   }
+   worker(0);
+   for (auto& th : threads) th.join();
+}
 void testing_next_permutation()
 {
    const int N_elems = 4;
@@ -3562,23 +6776,462 @@ void testing_next_permutation()
    printf("permutation %2d/%2ld of v: ", i, N_permutations);
    print_elements(v);
 }
+void testing_permutation_unranking()
+{
+   {
+      const std::vector<char> v = { 'a','b','c','d' };
+      std::vector<char> perm;
+      for (uint64_t rank = 0; rank < factorial<4>::val; rank += 5) {
+         unrank_permutation(v, rank, perm);
+         cout << "permutation #" << std::setw(2) << rank << ": ";
+         print_elements(perm);
+      }
+      cout << "20! = " << factorial<20>::val << "\n";
+   }
+   cout << "–––\n";
+   // all permutations of 0..N-1, checksum over all of them: sum of perm[0]*N + perm[N-1]
+   const unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+   for (int N = 11; N <= 13; ++N) {
+      std::vector<int> v(N);
+      std::iota(v.begin(), v.end(), 0);
+      uint64_t sum_serial = 0;
+      long t0 = nanos();
+      do {
+         sum_serial += v[0]*N + v[N-1];
+      } while (std::next_permutation(v.begin(), v.end()));
+      long t1 = nanos();
+      cout << "N=" << N << " (" << std::setw(10) << factorial_u64(N) << " permutations)  serial next_permutation:    "
+           << std::setw(6) << (t1-t0)/1000000 << " ms\n";
+
+      for (const unsigned n_th : {n_threads, 4u}) {
+         // per-thread sums, padded to a cache line each (no false sharing)
+         struct alignas(64) padded_sum { uint64_t val = 0; };
+         std::vector<padded_sum> sums(n_th);
+         t0 = nanos();
+         parallel_for_each_permutation(v, n_th, [&sums, N](const std::vector<int>& perm, unsigned thread_idx) {
+            sums[thread_idx].val += perm[0]*N + perm[N-1];
+         });
+         t1 = nanos();
+         uint64_t sum_parallel = 0;
+         for (const auto& s : sums) sum_parallel += s.val;
+         cout << "N=" << N << " (" << std::setw(10) << factorial_u64(N) << " permutations)  unranked chunks, " << n_th
+              << " thread(s): " << std::setw(6) << (t1-t0)/1000000 << " ms"
+              << (sum_parallel == sum_serial ? "" : "  CHECKSUM DIFFERS") << "\n";
+      }
+   }
+}
+
+// for 'testing_shuffle'
+/*
+   counter_rng: counter-based generator, output i of stream s is splitmix64_mix(key(seed,s) + i*gamma)
+   => every (seed, stream) pair is an independent sequence, which any thread can generate without shared state
+   - satisfies UniformRandomBitGenerator (usable with the <random> distributions and std::shuffle)
+   - below(bound): uniform in [0,bound) without bias (Lemire: multiply-shift, rejection of the few biased products)
+   - bit(): 1 random bit, 64 of them per generated number
+*/
+class counter_rng {
+public:
+   using result_type = uint64_t;
+
+   explicit counter_rng(uint64_t seed, uint64_t stream = 0)
+      : m_key(splitmix64_mix(seed ^ splitmix64_mix(stream + 0x632be59bd9b4e019ULL))) {}
+
+   static constexpr result_type min() { return 0; }
+   static constexpr result_type max() { return ~result_type(0); }
+   result_type operator()() { return splitmix64_mix(m_key + ++m_counter*0x9e3779b97f4a7c15ULL); }
+
+   uint64_t below(uint64_t bound) {
+      uint128_t m = (uint128_t) (*this)() * bound;
+      if ((uint64_t) m < bound) {
+         const uint64_t threshold = -bound % bound;
+         while ((uint64_t) m < threshold) {
+            m = (uint128_t) (*this)() * bound;
+         }
+      }
+      return (uint64_t) (m >> 64);
+   }
+   bool bit() {
+      if (m_n_bits == 0) {
+         m_bits = (*this)();
+         m_n_bits = 64;
+      }
+      const bool b = m_bits & 1;
+      m_bits >>= 1;
+      --m_n_bits;
+      return b;
+   }
 
+private:
+   uint64_t m_key;
+   uint64_t m_counter = 0;
+   uint64_t m_bits = 0;
+   int m_n_bits = 0;
+};
+// f(i) for i in [0,n), the indices are handed out dynamically to n_threads threads (atomic counter)
+template <typename F>
+void parallel_for_index(size_t n, unsigned n_threads, F f)
+{
+   std::atomic<size_t> next{0};
+   auto worker = [&]{
+      for (size_t i = next++; i < n; i = next++) f(i);
+   };
+   std::vector<std::thread> threads;
+   for (unsigned t = 1; t < std::min<size_t>(std::max(1u, n_threads), n); ++t) {
+      threads.emplace_back(worker);
+   }
+   worker();
+   for (auto& th : threads) th.join();
+}
+/*
+   random merge of MergeShuffle (Bacher, Bodini, Hollender, Lumbroso 2015):
+   [t, t+m) and [t+m, t+n) are each uniformly shuffled => [t, t+n) is afterwards
+   - a coin flip per element decides whether the next element comes from the left or from the right part,
+   - when one part runs out, each remaining element is swapped with a random position before it (Fisher-Yates step)
+*/
+template <typename RandomIt>
+void random_merge(RandomIt t, size_t m, size_t n, counter_rng& rng)
+{
+   size_t u = 0, v = m;
+   while (true) {
+      if (rng.bit()) {
+         if (v == n) break;
+         std::iter_swap(t + u, t + v);
+         ++v;
+      } else if (u == v) {
+         break;
+      }
+      ++u;
+   }
+   for (; u < n; ++u) {
+      std::iter_swap(t + rng.below(u + 1), t + u);
+   }
+}
+/*
+   merge_shuffle: parallel, reproducible shuffle
+   - the range is split into leaves of leaf_size elements, each shuffled with Fisher-Yates,
+     then merged pairwise with random_merge, level by level (the merges of a level in parallel)
+   - leaf i uses stream i of counter_rng(seed), the merge of node j on level l stream (l << 40) | j
+     => the result only depends on (seed, size, leaf_size), not on n_threads or on which thread did what
+   - the merges of the upper levels are sequential (the last one is a single O(n) pass)
+*/
+template <typename RandomIt>
+void merge_shuffle(RandomIt first, RandomIt last, uint64_t seed,
+                   unsigned n_threads = std::thread::hardware_concurrency(), size_t leaf_size = 1 << 15)
+{
+   const size_t n = last - first;
+   leaf_size = std::max<size_t>(leaf_size, 1);
+   const size_t n_leaves = (n + leaf_size - 1)/leaf_size;
+   parallel_for_index(n_leaves, n_threads, [&](size_t i) {
+      counter_rng rng(seed, i);
+      RandomIt leaf = first + i*leaf_size;
+      for (size_t k = std::min(leaf_size, n - i*leaf_size); k > 1; --k) {
+         std::iter_swap(leaf + (k-1), leaf + rng.below(k));
+      }
+   });
+   uint64_t level = 1;
+   for (size_t width = leaf_size; width < n; width *= 2, ++level) {
+      const size_t n_merges = (n + 2*width - 1)/(2*width);
+      parallel_for_index(n_merges, n_threads, [&](size_t j) {
+         const size_t lo = j*2*width;
+         const size_t mid = std::min(lo + width, n);
+         const size_t hi = std::min(lo + 2*width, n);
+         if (mid < hi) {
+            counter_rng rng(seed, (level << 40) | j);
+            random_merge(first + lo, mid - lo, hi - lo, rng);
+         }
+      });
+   }
+}
+template <typename T>
+void merge_shuffle(std::vector<T>& v, uint64_t seed, unsigned n_threads = std::thread::hardware_concurrency())
+{
+   merge_shuffle(v.begin(), v.end(), seed, n_threads);
+}
 void testing_shuffle()
 {
    const int N = 20;
    std::vector<int> v(N);
    for (size_t i=0; i<v.size(); ++i) { v[i] = int((static_cast<double>(rand())/RAND_MAX)*100); }
    print_elements(v, "v initially:       ");
-   std::random_shuffle(v.begin(), v.end());
+   // std::random_shuffle is deprecated since C++14 and removed in C++17
+   //std::random_shuffle(v.begin(), v.end());
+   merge_shuffle(v, 1);
    print_elements(v, "v after shuffle 1: ");
-   std::random_shuffle(v.begin(), v.end());
+   //std::random_shuffle(v.begin(), v.end());
+   merge_shuffle(v, 2);
    print_elements(v, "v after shuffle 2: ");
 
    std::default_random_engine dre;
    std::shuffle(v.begin(), v.end(), dre);
    print_elements(v, "v after shuffle 3: ");
 }
+void testing_merge_shuffle()
+{
+   {
+      // uniformity: all 24 permutations of 4 elements, leaves of 1 element => only random merges
+      std::map<std::vector<int>, int> counts;
+      const int n_trials = 240000;
+      for (int seed = 0; seed < n_trials; ++seed) {
+         std::vector<int> v = { 0,1,2,3 };
+         merge_shuffle(v.begin(), v.end(), seed, 1, 1);
+         ++counts[v];
+      }
+      double chi2 = 0.0;
+      for (const auto& [perm, count] : counts) {
+         chi2 += (count - n_trials/24.0)*(count - n_trials/24.0)/(n_trials/24.0);
+      }
+      cout << "merge_shuffle of 4 elements, " << n_trials << " seeds: " << counts.size()
+           << " different permutations, chi2/df = " << chi2/23 << " (~1 expected)\n";
+   }
+   {
+      // reproducible: same seed => same result, whatever the number of threads
+      std::vector<int> v1(10000000), v2(10000000);
+      std::iota(v1.begin(), v1.end(), 0);
+      std::iota(v2.begin(), v2.end(), 0);
+      merge_shuffle(v1, 42, 1);
+      merge_shuffle(v2, 42, 4);
+      cout << "merge_shuffle, 1 vs 4 threads, same seed: " << (v1 == v2 ? "same" : "DIFFERENT") << " result\n";
+   }
+   cout << "–––\n";
+   // 1e9 ints (4 GB), less if the machine does not have 1.5x that
+   size_t N = 1000000000;
+   const size_t phys_bytes = (size_t) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE);
+   if (1.5*N*sizeof(int) > phys_bytes) {
+      N = phys_bytes/sizeof(int)/2;
+      cout << "(reduced to " << N << " ints, " << phys_bytes/1000000 << " MB RAM)\n";
+   }
+   std::vector<int, default_init_allocator<int>> v(N);
+   std::iota(v.begin(), v.end(), 0);
+   const unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+   bench_harness bench(0, 1);
+   bench_harness::print_stats(cout, "std::shuffle, default_random_engine, " + std::to_string(N) + " ints",
+      bench.measure([&]{ std::shuffle(v.begin(), v.end(), std::default_random_engine(1)); }), N);
+   bench_harness::print_stats(cout, "std::shuffle, mt19937_64, " + std::to_string(N) + " ints",
+      bench.measure([&]{ std::shuffle(v.begin(), v.end(), std::mt19937_64(1)); }), N);
+   bench_harness::print_stats(cout, "merge_shuffle, " + std::to_string(n_threads) + " thread(s), " + std::to_string(N) + " ints",
+      bench.measure([&]{ merge_shuffle(v.begin(), v.end(), 1, n_threads); }), N);
+}
 
+// for 'testing_dyn_bitset'
+/*
+   popcount of n words
+   - generic: __builtin_popcountll, without -mpopcnt a bit-twiddling sequence (baseline x86-64 has no POPCNT)
+   - POPCNT instruction: 1 word per instruction
+   - AVX2 (Mula): popcount of every nibble of 4 words via a 16-entry lookup table (vpshufb),
+     the byte counts summed per 64-bit lane with vpsadbw
+*/
+inline uint64_t popcount_words_generic(const uint64_t* w, size_t n)
+{
+   uint64_t total = 0;
+   for (size_t i = 0; i < n; ++i) total += __builtin_popcountll(w[i]);
+   return total;
+}
+__attribute__((target("popcnt")))
+inline uint64_t popcount_words_popcnt(const uint64_t* w, size_t n)
+{
+   uint64_t total = 0;
+   for (size_t i = 0; i < n; ++i) total += __builtin_popcountll(w[i]);
+   return total;
+}
+__attribute__((target("avx2,popcnt")))
+inline uint64_t popcount_words_avx2(const uint64_t* w, size_t n)
+{
+   const __m256i lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                           0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+   const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+   __m256i acc = _mm256_setzero_si256();
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+      const __m256i lo = _mm256_and_si256(v, low_nibbles);
+      const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibbles);
+      const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+   }
+   uint64_t total = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+                  + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+   for (; i < n; ++i) total += __builtin_popcountll(w[i]);
+   return total;
+}
+inline uint64_t popcount_words(const uint64_t* w, size_t n)
+{
+   static const bool has_popcnt = __builtin_cpu_supports("popcnt");
+   if (cpu_has_avx2()) return popcount_words_avx2(w, n);
+   if (has_popcnt) return popcount_words_popcnt(w, n);
+   return popcount_words_generic(w, n);
+}
+// a[i] = a[i] OP b[i] for n words
+enum class BITOP { AND, OR, XOR, ANDNOT };
+template <BITOP OP>
+inline uint64_t bit_op(uint64_t a, uint64_t b)
+{
+   switch (OP) {
+      case BITOP::AND: return a & b;
+      case BITOP::OR:  return a | b;
+      case BITOP::XOR: return a ^ b;
+      default:         return a & ~b;
+   }
+}
+template <BITOP OP>
+__attribute__((target("avx2")))
+void bit_op_words_avx2(uint64_t* a, const uint64_t* b, size_t n)
+{
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+      const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+      __m256i r;
+      if constexpr (OP == BITOP::AND) r = _mm256_and_si256(va, vb);
+      else if constexpr (OP == BITOP::OR) r = _mm256_or_si256(va, vb);
+      else if constexpr (OP == BITOP::XOR) r = _mm256_xor_si256(va, vb);
+      else r = _mm256_andnot_si256(vb, va);   // ~vb & va
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), r);
+   }
+   for (; i < n; ++i) a[i] = bit_op<OP>(a[i], b[i]);
+}
+template <BITOP OP>
+void bit_op_words(uint64_t* a, const uint64_t* b, size_t n)
+{
+   if (cpu_has_avx2()) {
+      bit_op_words_avx2<OP>(a, b, n);
+      return;
+   }
+   for (size_t i = 0; i < n; ++i) a[i] = bit_op<OP>(a[i], b[i]);
+}
+/*
+   dyn_bitset: bitset with its size chosen at runtime, e.g. a row-selection mask over a table
+   - storage: blocks of 8 words aligned to 64 bytes (alignas => C++17 aligned new inside std::vector),
+     a block is one cache line or 2 AVX2 registers; the bits past size() are always 0
+     => the bulk operations run over whole blocks, no masking of a last partial word
+   - count(), &=, |=, ^=, andnot(): word-parallel over the whole range, see popcount_words, bit_op_words
+   - for_each_set(f): f(i) for the set bits in increasing order, tzcnt + clearing the lowest set bit
+     => cost ~ number of words + number of set bits, instead of number of bits
+   - to_rows(rows): the set bits as a selection vector (like the filters of 'CustomerTable')
+   std::vector<bool>: no bulk operations, every bit goes through a proxy reference;
+   std::bitset<N>: the size is fixed at compile time
+*/
+class dyn_bitset {
+public:
+   static constexpr size_t WORD_BITS = 64;
+   static constexpr size_t BLOCK_WORDS = 8;
+
+   dyn_bitset() = default;
+   explicit dyn_bitset(size_t n_bits, bool value = false)
+      : m_n_bits(n_bits), m_blocks((n_bits + BLOCK_WORDS*WORD_BITS - 1)/(BLOCK_WORDS*WORD_BITS))
+   {
+      if (value) {
+         std::fill(words(), words() + n_words(), ~0ULL);
+         clear_padding();
+      }
+   }
+
+   size_t size() const { return m_n_bits; }
+   size_t n_words() const { return m_blocks.size()*BLOCK_WORDS; }   // including the padding words
+   uint64_t* words() { return m_blocks.empty() ? nullptr : m_blocks[0].w; }
+   const uint64_t* words() const { return m_blocks.empty() ? nullptr : m_blocks[0].w; }
+   // after writing words() directly: the bits past size() must be 0 again
+   void clear_padding() {
+      uint64_t* w = words();
+      if (m_n_bits % WORD_BITS) w[m_n_bits/WORD_BITS] &= (1ULL << (m_n_bits % WORD_BITS)) - 1;
+      for (size_t i = (m_n_bits + WORD_BITS - 1)/WORD_BITS; i < n_words(); ++i) w[i] = 0;
+   }
+
+   bool test(size_t i) const { assert(i < m_n_bits); return (words()[i/WORD_BITS] >> (i % WORD_BITS)) & 1; }
+   void set(size_t i)   { assert(i < m_n_bits); words()[i/WORD_BITS] |= 1ULL << (i % WORD_BITS); }
+   void reset(size_t i) { assert(i < m_n_bits); words()[i/WORD_BITS] &= ~(1ULL << (i % WORD_BITS)); }
+
+   uint64_t count() const { return popcount_words(words(), n_words()); }
+   dyn_bitset& operator&=(const dyn_bitset& other) { return apply<BITOP::AND>(other); }
+   dyn_bitset& operator|=(const dyn_bitset& other) { return apply<BITOP::OR>(other); }
+   dyn_bitset& operator^=(const dyn_bitset& other) { return apply<BITOP::XOR>(other); }
+   dyn_bitset& andnot(const dyn_bitset& other)     { return apply<BITOP::ANDNOT>(other); }   // *this & ~other
+
+   template <typename F>
+   void for_each_set(F f) const {
+      const uint64_t* w = words();
+      for (size_t i = 0; i < n_words(); ++i) {
+         for (uint64_t bits = w[i]; bits; bits &= bits - 1) {
+            f(i*WORD_BITS + __builtin_ctzll(bits));
+         }
+      }
+   }
+   void to_rows(std::vector<uint32_t>& rows) const {
+      rows.clear();
+      rows.reserve(count());
+      for_each_set([&](size_t i) { rows.push_back((uint32_t) i); });
+   }
+
+private:
+   struct alignas(64) block { uint64_t w[BLOCK_WORDS]; };
+   static_assert(sizeof(block) == 64, "a block is one cache line");
+
+   template <BITOP OP>
+   dyn_bitset& apply(const dyn_bitset& other) {
+      assert(m_n_bits == other.m_n_bits);
+      bit_op_words<OP>(words(), other.words(), n_words());
+      return *this;
+   }
+
+   size_t m_n_bits = 0;
+   std::vector<block> m_blocks;   // value-initialized => all bits 0
+};
+/*
+   bitset_rank_select: rank/select over a dyn_bitset, a snapshot (rebuild after modifying the bitset,
+   which has to outlive it)
+   - rank(i): number of set bits in [0,i) = cumulative count before i's 512-bit block
+     (8 bytes per block, +1.6% memory) + popcounts of at most 8 words => O(1)
+   - select(k): position of the set bit with rank k (k from 0), size() if k >= count():
+     the block of every SELECT_SAMPLE-th set bit is sampled => a binary search of the block counts
+     between 2 samples only, a scan of the words of the block, then the k-th set bit of one word
+     by clearing its lowest set bits
+   => e.g. 'the k-th selected row' without materializing the selection vector
+*/
+class bitset_rank_select {
+public:
+   static constexpr uint64_t SELECT_SAMPLE = 4096;
+
+   explicit bitset_rank_select(const dyn_bitset& bits)
+      : m_bits(bits), m_block_rank(bits.n_words()/dyn_bitset::BLOCK_WORDS + 1, 0)
+   {
+      const uint64_t* w = bits.words();
+      for (size_t b = 0; b + 1 < m_block_rank.size(); ++b) {
+         m_block_rank[b+1] = m_block_rank[b] + popcount_words(w + b*dyn_bitset::BLOCK_WORDS, dyn_bitset::BLOCK_WORDS);
+         while (m_select_sample.size()*SELECT_SAMPLE < m_block_rank[b+1]) m_select_sample.push_back(b);
+      }
+   }
+
+   uint64_t count() const { return m_block_rank.back(); }
+   uint64_t rank(size_t i) const {
+      assert(i <= m_bits.size());
+      const size_t word = i/dyn_bitset::WORD_BITS;
+      const size_t block = word/dyn_bitset::BLOCK_WORDS;
+      const uint64_t* w = m_bits.words();
+      uint64_t r = m_block_rank[block];
+      for (size_t k = block*dyn_bitset::BLOCK_WORDS; k < word; ++k) r += __builtin_popcountll(w[k]);
+      if (i % dyn_bitset::WORD_BITS) r += __builtin_popcountll(w[word] << (dyn_bitset::WORD_BITS - i % dyn_bitset::WORD_BITS));
+      return r;
+   }
+   size_t select(uint64_t k) const {
+      if (k >= count()) return m_bits.size();
+      // last block whose cumulative count is <= k, between the blocks of the samples before and after k
+      const size_t j = k/SELECT_SAMPLE;
+      const size_t lo = m_select_sample[j];
+      const size_t hi = j + 1 < m_select_sample.size() ? m_select_sample[j+1] + 1 : m_block_rank.size() - 1;
+      const size_t block = std::upper_bound(m_block_rank.begin() + lo, m_block_rank.begin() + hi, k) - m_block_rank.begin() - 1;
+      k -= m_block_rank[block];
+      const uint64_t* w = m_bits.words() + block*dyn_bitset::BLOCK_WORDS;
+      size_t i = 0;
+      for (uint64_t c; k >= (c = __builtin_popcountll(w[i])); ++i) k -= c;
+      uint64_t bits = w[i];
+      for (; k > 0; --k) bits &= bits - 1;
+      return (block*dyn_bitset::BLOCK_WORDS + i)*dyn_bitset::WORD_BITS + __builtin_ctzll(bits);
+   }
+
+private:
+   const dyn_bitset& m_bits;
+   std::vector<uint64_t> m_block_rank;       // set bits before block b
+   std::vector<size_t> m_select_sample;      // block of the set bit with rank j*SELECT_SAMPLE
+};
 void testing_bitset()
 {
    {
@@ -3591,18 +7244,511 @@ void testing_bitset()
          cout << "  binary(" << i << "),num set bits: " << std::bitset<16>(i) << "," << std::bitset<16>(i).count() << "\n";
       }
    }
-   {
-      int i = 12345678;
-      std::string s = std::bitset<32>(i).to_string();
-      cout << "i=" << i << " as string: " << s << "\n";
+   {
+      int i = 12345678;
+      std::string s = std::bitset<32>(i).to_string();
+      cout << "i=" << i << " as string: " << s << "\n";
+   }
+   {
+      std::string s = "1010111100001001";
+      unsigned long num = std::bitset<32>(s).to_ulong();
+      cout << "s=\"" << s << "\" as number: " << num << "\n";
+   }
+}
+
+void testing_dyn_bitset()
+{
+   {
+      // row selection over a table of 200 rows
+      dyn_bitset even(200), div3(200);
+      for (size_t i = 0; i < 200; ++i) {
+         if (i % 2 == 0) even.set(i);
+         if (i % 3 == 0) div3.set(i);
+      }
+      dyn_bitset both = even;
+      both &= div3;
+      dyn_bitset either = even;
+      either |= div3;
+      dyn_bitset only_even = even;
+      only_even.andnot(div3);
+      cout << "200 rows: even " << even.count() << ", divisible by 3 " << div3.count()
+           << ", both " << both.count() << ", either " << either.count() << ", only even " << only_even.count() << "\n";
+      std::vector<uint32_t> rows;
+      both.to_rows(rows);
+      print_elements(rows, "rows divisible by 6: ");
+      bitset_rank_select rs(both);
+      cout << "rank(100) = " << rs.rank(100) << " rows before row 100, select(10) = row " << rs.select(10) << "\n";
+   }
+   {
+      // rank/select against a scan, random bits of random density
+      splitmix64_stream e{5};
+      bool ok = true;
+      for (const size_t n : {1UL, 63UL, 64UL, 511UL, 512UL, 513UL, 100000UL}) {
+         for (const uint64_t density_shift : {0, 2, 6}) {
+            dyn_bitset bits(n);
+            for (size_t i = 0; i < n; ++i) {
+               if ((e() >> (64 - density_shift - 1)) == 0) bits.set(i);   // probability 2^-(density_shift+1)
+            }
+            bitset_rank_select rs(bits);
+            uint64_t r = 0;
+            for (size_t i = 0; i < n; ++i) {
+               ok &= rs.rank(i) == r;
+               if (bits.test(i)) {
+                  ok &= rs.select(r) == i;
+                  ++r;
+               }
+            }
+            ok &= rs.rank(n) == r && rs.count() == r && bits.count() == r && rs.select(r) == n;
+         }
+      }
+      cout << "rank/select == scan: " << (ok ? "yes" : "NO") << "\n";
+   }
+   cout << "–––\n";
+   {
+      // 1e9-bit filters: 50% dense for count/and, 1% sparse for the iteration over set bits
+      constexpr size_t N = 1000000000;
+      auto report = [](const std::string& name, const bench_stats& st) {
+         cout << std::setw(44) << std::left << name << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << st.median/1e6 << " ms  (" << std::setprecision(3) << (double) N/st.median << " bits/ns)\n"
+              << std::defaultfloat << std::setprecision(6);
+      };
+      splitmix64_stream e{9};
+      dyn_bitset a(N), b(N), sparse(N);
+      std::generate(a.words(), a.words() + a.n_words(), std::ref(e));
+      std::generate(b.words(), b.words() + b.n_words(), std::ref(e));
+      a.clear_padding();
+      b.clear_padding();
+      std::vector<bool> va(N), vb(N), vsparse(N);
+      auto bs_a = std::make_unique<std::bitset<N>>();
+      auto bs_b = std::make_unique<std::bitset<N>>();
+      auto bs_sparse = std::make_unique<std::bitset<N>>();
+      for (size_t i = 0; i < N; ++i) {
+         va[i] = (*bs_a)[i] = a.test(i);
+         vb[i] = (*bs_b)[i] = b.test(i);
+      }
+      for (size_t k = 0; k < N/100; ++k) {
+         const size_t i = e() % N;
+         sparse.set(i);
+         vsparse[i] = true;
+         bs_sparse->set(i);
+      }
+      bench_harness bench(1, 3);
+      uint64_t sink = 0;
+      report("count: std::vector<bool>, std::count", bench.measure([&]{ sink += std::count(va.begin(), va.end(), true); }));
+      report("count: std::bitset::count", bench.measure([&]{ sink += bs_a->count(); }));
+      report("count: dyn_bitset, generic popcount", bench.measure([&]{ sink += popcount_words_generic(a.words(), a.n_words()); }));
+      report("count: dyn_bitset, POPCNT", bench.measure([&]{ sink += popcount_words_popcnt(a.words(), a.n_words()); }));
+      report("count: dyn_bitset::count (AVX2)", bench.measure([&]{ sink += a.count(); }));
+      cout << "–––\n";
+      report("and: std::vector<bool>, bit by bit", bench.measure([&]{
+         for (size_t i = 0; i < N; ++i) va[i] = va[i] && vb[i];
+      }));
+      report("and: std::bitset &=", bench.measure([&]{ *bs_a &= *bs_b; }));
+      report("and: dyn_bitset &=", bench.measure([&]{ a &= b; }));
+      cout << "–––\n";
+      report("set bits (1%): std::vector<bool>, scan", bench.measure([&]{
+         for (size_t i = 0; i < N; ++i) if (vsparse[i]) sink += i;
+      }));
+      report("set bits (1%): std::bitset _Find_next", bench.measure([&]{
+         for (size_t i = bs_sparse->_Find_first(); i < N; i = bs_sparse->_Find_next(i)) sink += i;
+      }));
+      report("set bits (1%): dyn_bitset::for_each_set", bench.measure([&]{ sparse.for_each_set([&](size_t i) { sink += i; }); }));
+      do_not_optimize(sink);
+      cout << "results equal: " << (a.count() == bs_a->count() && a.count() == (uint64_t) std::count(va.begin(), va.end(), true)
+                                    && sparse.count() == bs_sparse->count() ? "yes" : "NO") << "\n";
+      cout << "–––\n";
+      std::unique_ptr<bitset_rank_select> rs;
+      report("rank/select: build", bench.measure([&]{ rs = std::make_unique<bitset_rank_select>(a); }));
+      const size_t n_queries = 1000000;
+      std::vector<uint64_t> queries(n_queries);
+      for (auto& q : queries) q = e() % N;
+      bench_harness::print_stats(cout, "rank, random positions", bench.measure([&]{
+         for (const auto q : queries) sink += rs->rank(q);
+         do_not_optimize(sink);
+      }), n_queries);
+      const uint64_t n_set = rs->count();
+      bench_harness::print_stats(cout, "select, random ranks", bench.measure([&]{
+         for (const auto q : queries) sink += rs->select(q % n_set);
+         do_not_optimize(sink);
+      }), n_queries);
+   }
+}
+
+// for 'testing_split'
+/*
+   split(s, sep) / split(s, seps): lazy tokenizer over a string_view, the tokens are string_views into s
+   (no copies, no allocation; s has to outlive the tokens)
+   - semantics of the getline() tokenizer of 'testing_string' (p.678):
+     n separators => n+1 tokens, empty tokens between adjacent separators and after a trailing separator
+     are kept, an empty input has no tokens
+   - SPLIT_TRIM::NONE:           tokens as they are
+     SPLIT_TRIM::BLANK_TO_EMPTY: tokens of only ' ' become "", the others stay untrimmed (as in p.678)
+     SPLIT_TRIM::SPACES:         leading and trailing ' ' removed
+   - SPLIT_EMPTY::KEEP / SKIP:   empty tokens (after trimming) are returned / dropped
+   - separator scan: up to 8 AVX2 byte compares per 32 bytes (inline: the tokens are short, a call
+     of glibc's memchr per token costs more than its SIMD saves); without AVX2 memchr for one
+     separator, a 256-entry lookup table per byte for a set
+*/
+enum class SPLIT_TRIM { NONE, BLANK_TO_EMPTY, SPACES };
+enum class SPLIT_EMPTY { KEEP, SKIP };
+__attribute__((target("avx2")))
+inline const char* find_first_of_avx2(const char* p, const char* end, const std::string& seps, const std::array<bool,256>& is_sep)
+{
+   __m256i sep[8];
+   const size_t n_seps = seps.size();
+   for (size_t k = 0; k < n_seps; ++k) sep[k] = _mm256_set1_epi8(seps[k]);
+   for (; p + 32 <= end; p += 32) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      __m256i eq = _mm256_cmpeq_epi8(v, sep[0]);
+      for (size_t k = 1; k < n_seps; ++k) eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(v, sep[k]));
+      const uint32_t mask = _mm256_movemask_epi8(eq);
+      if (mask) return p + __builtin_ctz(mask);
+   }
+   for (; p < end; ++p) {
+      if (is_sep[(unsigned char) *p]) return p;
+   }
+   return end;
+}
+class split_view {
+public:
+   class iterator {
+   public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = std::string_view;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const std::string_view*;
+      using reference = const std::string_view&;
+
+      iterator() = default;
+      reference operator*() const { return m_token; }
+      pointer operator->() const { return &m_token; }
+      iterator& operator++() { advance(); return *this; }
+      iterator operator++(int) { iterator tmp = *this; advance(); return tmp; }
+      bool operator==(const iterator& other) const { return m_field == other.m_field; }
+      bool operator!=(const iterator& other) const { return m_field != other.m_field; }
+
+   private:
+      friend class split_view;
+      iterator(const split_view* view, const char* first) : m_view(view), m_next(first) { advance(); }
+
+      // next token, m_field == nullptr at the end
+      void advance() {
+         do {
+            if (m_next == nullptr) {
+               m_field = nullptr;
+               return;
+            }
+            m_field = m_next;
+            const char* end = m_view->m_s.data() + m_view->m_s.size();
+            const char* sep = m_view->find_sep(m_field, end);
+            m_next = sep == end ? nullptr : sep + 1;
+            m_token = m_view->trim(std::string_view(m_field, sep - m_field));
+         } while (m_token.empty() && m_view->m_empty == SPLIT_EMPTY::SKIP);
+      }
+
+      const split_view* m_view = nullptr;
+      const char* m_field = nullptr;   // begin of the current field (untrimmed)
+      const char* m_next = nullptr;    // begin of the next field, nullptr after the last one
+      std::string_view m_token;
+   };
+
+   split_view(std::string_view s, char sep, SPLIT_TRIM trim = SPLIT_TRIM::NONE, SPLIT_EMPTY empty = SPLIT_EMPTY::KEEP)
+      : split_view(s, std::string_view(&sep, 1), trim, empty) {}
+   split_view(std::string_view s, std::string_view seps, SPLIT_TRIM trim = SPLIT_TRIM::NONE, SPLIT_EMPTY empty = SPLIT_EMPTY::KEEP)
+      : m_s(s), m_seps(seps), m_trim(trim), m_empty(empty)
+   {
+      assert(!seps.empty());
+      m_is_sep.fill(false);
+      for (const char c : seps) m_is_sep[(unsigned char) c] = true;
+   }
+
+   iterator begin() const { return m_s.empty() ? end() : iterator(this, m_s.data()); }
+   iterator end() const { return iterator(); }
+   std::vector<std::string_view> to_vector() const { return std::vector<std::string_view>(begin(), end()); }
+
+private:
+   const char* find_sep(const char* p, const char* end) const {
+      if (m_seps.size() <= 8 && cpu_has_avx2()) return find_first_of_avx2(p, end, m_seps, m_is_sep);
+      if (m_seps.size() == 1) {
+         const void* sep = std::memchr(p, m_seps[0], end - p);
+         return sep ? static_cast<const char*>(sep) : end;
+      }
+      for (; p < end; ++p) {
+         if (m_is_sep[(unsigned char) *p]) return p;
+      }
+      return end;
+   }
+   std::string_view trim(std::string_view token) const {
+      if (m_trim == SPLIT_TRIM::NONE) return token;
+      size_t first = 0, last = token.size();
+      if (token.size() <= 16 && token.data() + 16 <= m_s.data() + m_s.size()) {
+         // short token: one SSE2 compare of 16 bytes, first/last non-blank from the bit mask
+         // (a char loop mispredicts on every token with blanks)
+         const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(token.data()));
+         const unsigned non_blank = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' '))) & ((1u << token.size()) - 1);
+         if (non_blank == 0) return token.substr(0, 0);
+         if (m_trim == SPLIT_TRIM::BLANK_TO_EMPTY) return token;
+         first = __builtin_ctz(non_blank);
+         last = 32 - __builtin_clz(non_blank);
+      } else {
+         while (first < last && token[first] == ' ') ++first;
+         if (first == last) return token.substr(0, 0);
+         if (m_trim == SPLIT_TRIM::BLANK_TO_EMPTY) return token;
+         while (token[last-1] == ' ') --last;
+      }
+      return token.substr(first, last - first);
+   }
+
+   std::string_view m_s;
+   std::string m_seps;
+   std::array<bool,256> m_is_sep;
+   SPLIT_TRIM m_trim;
+   SPLIT_EMPTY m_empty;
+};
+inline split_view split(std::string_view s, char sep, SPLIT_TRIM trim = SPLIT_TRIM::NONE, SPLIT_EMPTY empty = SPLIT_EMPTY::KEEP)
+{
+   return split_view(s, sep, trim, empty);
+}
+inline split_view split(std::string_view s, std::string_view seps, SPLIT_TRIM trim = SPLIT_TRIM::NONE, SPLIT_EMPTY empty = SPLIT_EMPTY::KEEP)
+{
+   return split_view(s, seps, trim, empty);
+}
+// the getline() tokenizer of 'testing_string' (p.678) as a function, without its output
+std::vector<std::string> tokenize_getline(const std::string& input, const char token_sep)
+{
+   std::istringstream iss(input);
+   std::vector<std::string> token_vec;
+   std::string token;
+   while (getline(iss,token,token_sep)) {
+      if (token.find_first_not_of(' ') == std::string::npos) {
+         token_vec.push_back("");
+      } else {
+         token_vec.push_back(std::move(token));
+      }
+   }
+   if (!input.empty() && input.back() == token_sep) {
+      token_vec.push_back("");
+   }
+   return token_vec;
+}
+// for 'testing_icase_search'
+/*
+   ascii_icase_searcher: case-insensitive (ASCII letters only) substring search, a searcher object
+   like std::boyer_moore_horspool_searcher => std::search(first, last, searcher) on contiguous chars
+   - instead of toupper() twice per char compare (a call and a locale lookup each):
+     the needle is lowercased once, the haystack folded with a 256-entry table only where needed
+   - SIMD filter (AVX2): 32 candidate positions at a time, a position is only verified if its first
+     and its last char equal (case-insensitively) the needle's first/last char,
+     letters are compared as (c | 0x20) == lowercase letter, which is exact for letters
+   - Boyer-Moore-Horspool (no AVX2, or needles of at least horspool_min_len chars): the shift table
+     is indexed by the folded char => skips of up to the needle length per window
+   measured on English-like text, the SIMD filter beat Horspool for needles of 8 up to 2048 chars
+   (the letters of a text occur near the end of a long needle too => short skips), so Horspool is
+   only the default without AVX2; horspool_min_len is for haystacks where the first/last char filter
+   lets many positions through (e.g. long runs of the same char)
+*/
+struct ascii_fold {
+   std::array<unsigned char,256> lower;
+   constexpr ascii_fold() : lower() {
+      for (int c = 0; c < 256; ++c) lower[c] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+   }
+   unsigned char operator()(char c) const { return lower[(unsigned char) c]; }
+};
+inline constexpr ascii_fold fold_ascii;
+// char pointers, std::string and std::vector<char> iterators (see 'is_contiguous_iterator')
+template <typename It>
+constexpr bool is_contiguous_char_iterator =
+   std::is_same<typename std::iterator_traits<It>::value_type, char>::value &&
+   (is_contiguous_iterator<It>::value ||
+    std::is_same<It, std::string::iterator>::value || std::is_same<It, std::string::const_iterator>::value);
+class ascii_icase_searcher {
+public:
+   static constexpr size_t NO_HORSPOOL = std::numeric_limits<size_t>::max();
+
+   explicit ascii_icase_searcher(std::string_view needle, size_t horspool_min_len = NO_HORSPOOL)
+      : m_needle(needle), m_horspool_min_len(horspool_min_len)
+   {
+      for (auto& c : m_needle) c = fold_ascii(c);
+      m_shift.fill(m_needle.size());
+      for (size_t i = 0; i + 1 < m_needle.size(); ++i) {
+         m_shift[(unsigned char) m_needle[i]] = m_needle.size() - 1 - i;
+      }
+   }
+
+   // offset of the first match in haystack at or after pos, or npos
+   size_t find(std::string_view haystack, size_t pos = 0) const {
+      const size_t m = m_needle.size();
+      if (pos > haystack.size() || m > haystack.size() - pos) return std::string_view::npos;
+      if (m == 0) return pos;
+      const char* p = haystack.data();
+      if (m < m_horspool_min_len && cpu_has_avx2()) return find_avx2(p, pos, haystack.size());
+      return find_horspool(p, pos, haystack.size());
+   }
+   // for std::search(first, last, searcher)
+   template <typename RandomIt>
+   std::pair<RandomIt,RandomIt> operator()(RandomIt first, RandomIt last) const {
+      static_assert(is_contiguous_char_iterator<RandomIt>,
+                    "ascii_icase_searcher: needs contiguous chars (char*, std::string or std::vector<char> iterators)");
+      if (first == last) return m_needle.empty() ? std::make_pair(first, first) : std::make_pair(last, last);
+      const size_t i = find(std::string_view(&*first, last - first));
+      if (i == std::string_view::npos) return { last, last };
+      return { first + i, first + i + m_needle.size() };
+   }
+
+private:
+   bool equal_at(const char* p) const {   // p[0, m) == needle, case-insensitively
+      for (size_t k = 0; k < m_needle.size(); ++k) {
+         if (fold_ascii(p[k]) != (unsigned char) m_needle[k]) return false;
+      }
+      return true;
+   }
+   size_t find_horspool(const char* p, size_t pos, size_t n) const {
+      const size_t m = m_needle.size();
+      const unsigned char last_char = m_needle[m-1];
+      for (size_t i = pos; i + m <= n; ) {
+         const unsigned char c = fold_ascii(p[i+m-1]);
+         if (c == last_char && equal_at(p + i)) return i;
+         i += m_shift[c];
+      }
+      return std::string_view::npos;
    }
-   {
-      std::string s = "1010111100001001";
-      unsigned long num = std::bitset<32>(s).to_ulong();
-      cout << "s=\"" << s << "\" as number: " << num << "\n";
+   __attribute__((target("avx2")))
+   size_t find_avx2(const char* p, size_t pos, size_t n) const {
+      const size_t m = m_needle.size();
+      const auto is_letter = [](char c) { return c >= 'a' && c <= 'z'; };
+      // (c | or_mask) == needle char
+      const __m256i first = _mm256_set1_epi8(m_needle[0]);
+      const __m256i last = _mm256_set1_epi8(m_needle[m-1]);
+      const __m256i first_or = _mm256_set1_epi8(is_letter(m_needle[0]) ? 0x20 : 0);
+      const __m256i last_or = _mm256_set1_epi8(is_letter(m_needle[m-1]) ? 0x20 : 0);
+      size_t i = pos;
+      for (; i + m - 1 + 32 <= n; i += 32) {
+         const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+         const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + m - 1));
+         const __m256i eq = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_or_si256(block_first, first_or), first),
+            _mm256_cmpeq_epi8(_mm256_or_si256(block_last, last_or), last));
+         for (uint32_t mask = _mm256_movemask_epi8(eq); mask; mask &= mask - 1) {
+            const size_t candidate = i + __builtin_ctz(mask);
+            if (equal_at(p + candidate)) return candidate;
+         }
+      }
+      for (; i + m <= n; ++i) {
+         if (equal_at(p + i)) return i;
+      }
+      return std::string_view::npos;
    }
+
+   std::string m_needle;                   // lowercase
+   size_t m_horspool_min_len;
+   std::array<size_t,256> m_shift;         // Horspool shift per folded char
+};
+// for 'testing_rewrite_extensions'
+/*
+   extension of a file name or path, rules of the p.656 example in 'testing_string':
+   - EXT_KIND::NONE:  no '.'                       "mydir"       => "mydir.tmp"
+     EXT_KIND::EMPTY: '.' is the last char         "hello."      => "hello.tmp"
+     EXT_KIND::SAME:  extension == the new suffix  "oops.tmp"    => "oops.tmp"
+     EXT_KIND::OTHER: another extension            "prog.dat"    => "prog.tmp"
+     EXT_KIND::NO_NAME: the last path component is empty, "." or "..", not a file name => left as is
+   - EXT_DOT::FIRST: the extension starts at the first '.' (as p.656: "some.file.name" => "some.tmp"),
+     EXT_DOT::LAST at the last one (as std::filesystem::path::extension(): "some.file.tmp")
+   - paths: only the last component counts ("dir.d/file" has no extension), a leading '.' of it
+     is not an extension (".bashrc", like std::filesystem)
+   - NONE and EMPTY are only reported by p.656, here the suffix is appended to them
+*/
+enum class EXT_KIND { NONE, EMPTY, SAME, OTHER, NO_NAME };
+enum class EXT_DOT { FIRST, LAST };
+struct path_extension {
+   EXT_KIND kind;
+   size_t dot;   // index of the '.' in the path, npos for EXT_KIND::NONE and NO_NAME
+};
+inline path_extension classify_extension(std::string_view path, std::string_view suffix, EXT_DOT which = EXT_DOT::FIRST)
+{
+   const size_t slash = path.rfind('/');
+   const size_t name_begin = slash == std::string_view::npos ? 0 : slash + 1;
+   const std::string_view name = path.substr(name_begin);
+   if (name.empty() || name == "." || name == "..") return { EXT_KIND::NO_NAME, std::string_view::npos };
+   const size_t dot_in_name = which == EXT_DOT::FIRST ? name.find('.', 1) : name.rfind('.');
+   if (dot_in_name == std::string_view::npos || dot_in_name == 0) return { EXT_KIND::NONE, std::string_view::npos };
+   const size_t dot = name_begin + dot_in_name;
+   if (dot + 1 == path.size()) return { EXT_KIND::EMPTY, dot };
+   if (path.substr(dot + 1) == suffix) return { EXT_KIND::SAME, dot };
+   return { EXT_KIND::OTHER, dot };
 }
+/*
+   rewritten_paths: the paths of a batch with their extension set to a new suffix, all in one arena
+   - rewrite() is 2 passes over the names: classify and sum up the output sizes, then copy the
+     pieces (string_views of the input + the suffix) into the arena
+     => 3 allocations per batch (arena, offsets, kinds), none when a rewritten_paths is reused for a
+        batch that fits into the capacity of the previous ones
+   - path i is a string_view into the arena, valid until the next rewrite()
+   instead of, per name, 2 substr() copies (base_name, ext_name) and a copy in 'tmp' to replace the suffix
+*/
+class rewritten_paths {
+public:
+   template <typename Names>
+   void rewrite(const Names& names, std::string_view suffix, EXT_DOT which = EXT_DOT::FIRST) {
+      const size_t n = std::size(names);
+      m_kinds.resize(n);
+      m_offsets.resize(n + 1);
+      m_offsets[0] = 0;
+      // pass 1: the length of every output, the dot is derived from it in pass 2
+      size_t i = 0;
+      for (const auto& name : names) {
+         const std::string_view path(name);
+         const path_extension ext = classify_extension(path, suffix, which);
+         m_kinds[i] = ext.kind;
+         size_t len = path.size();
+         switch (ext.kind) {
+            case EXT_KIND::NONE:  len += 1 + suffix.size(); break;
+            case EXT_KIND::EMPTY: len += suffix.size(); break;
+            case EXT_KIND::SAME:  break;
+            case EXT_KIND::OTHER: len = ext.dot + 1 + suffix.size(); break;
+            case EXT_KIND::NO_NAME: break;
+         }
+         m_offsets[i+1] = m_offsets[i] + len;
+         ++i;
+      }
+      m_arena.resize(m_offsets[n]);   // default_init_allocator => not zeroed first
+      // pass 2
+      i = 0;
+      for (const auto& name : names) {
+         const std::string_view path(name);
+         char* out = m_arena.data() + m_offsets[i];
+         const size_t len = m_offsets[i+1] - m_offsets[i];
+         switch (m_kinds[i]) {
+            case EXT_KIND::SAME:
+            case EXT_KIND::NO_NAME:
+               std::memcpy(out, path.data(), len);
+               break;
+            case EXT_KIND::NONE:
+               std::memcpy(out, path.data(), path.size());
+               out[path.size()] = '.';
+               std::memcpy(out + path.size() + 1, suffix.data(), suffix.size());
+               break;
+            case EXT_KIND::EMPTY:
+            case EXT_KIND::OTHER:   // the path up to and including its dot
+               std::memcpy(out, path.data(), len - suffix.size());
+               std::memcpy(out + len - suffix.size(), suffix.data(), suffix.size());
+               break;
+         }
+         ++i;
+      }
+   }
+
+   size_t size() const { return m_kinds.size(); }
+   std::string_view operator[](size_t i) const {
+      return std::string_view(m_arena.data() + m_offsets[i], m_offsets[i+1] - m_offsets[i]);
+   }
+   EXT_KIND kind(size_t i) const { return m_kinds[i]; }
+   size_t arena_bytes() const { return m_arena.size(); }
 
+private:
+   std::vector<char, default_init_allocator<char>> m_arena;
+   std::vector<size_t> m_offsets;   // path i is m_arena[m_offsets[i], m_offsets[i+1])
+   std::vector<EXT_KIND> m_kinds;
+};
 void testing_string()
 {
    {
@@ -3618,6 +7764,7 @@ void testing_string()
       print_elements(strings, "strings: ");
       const std::string suffix = "tmp";
       cout << "–––\n";
+      // see 'testing_rewrite_extensions' for rewriting whole batches without copies
       for (const auto& s : strings) {
          {
             auto idx = s.find('.'); // rfind to find last '.'
@@ -3779,6 +7926,7 @@ void testing_string()
          for (std::string query : {"tutorial", "Tutorial"}) {
             cout << "query (search case-insensitive): \"" << query << "\" => ";
             
+            // 2x toupper() per char compare, see 'testing_icase_search' for ascii_icase_searcher
             auto pos = std::search(
                s.cbegin(), s.cend(), 
                query.cbegin(), query.cend(),
@@ -3810,6 +7958,268 @@ void testing_string()
    }
 }
 
+void testing_split()
+{
+   {
+      // same tokens as the getline() tokenizer (p.678), for the inputs tried there
+      for (const std::string input : { " some text & 42:another token:1234 last token",
+                                       " some text & 42:another token:1234 last token:",
+                                       " some text & 42:another token:1234 last token:a",
+                                       " some text & 42:another token :1234 token: : ",
+                                       ":::" }) {
+         const auto tokens = split(input, ':', SPLIT_TRIM::BLANK_TO_EMPTY).to_vector();
+         const auto expected = tokenize_getline(input, ':');
+         const bool same = std::equal(tokens.begin(), tokens.end(), expected.begin(), expected.end());
+         cout << "|" << input << "|: " << tokens.size() << " tokens, " << (same ? "same as" : "DIFFERENT from") << " getline()\n";
+      }
+      const std::string input = " some text & 42:another token :1234 token: : ";
+      cout << "trimmed, without empty tokens:";
+      for (const auto t : split(input, ':', SPLIT_TRIM::SPACES, SPLIT_EMPTY::SKIP)) cout << " |" << t << "|";
+      cout << "\n";
+      cout << "split at any of \" :&\", without empty tokens:";
+      for (const auto t : split(input, " :&", SPLIT_TRIM::NONE, SPLIT_EMPTY::SKIP)) cout << " |" << t << "|";
+      cout << "\n";
+   }
+   cout << "–––\n";
+   {
+      // 1 GiB of ':' separated fields (0..15 letters, some blanks, a ';' in 1 of 16 fields)
+      size_t N = 1UL << 30;
+      const size_t phys_bytes = (size_t) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE);
+      if (3*N > phys_bytes) {   // the text + the copy in the istringstream
+         N = phys_bytes/4;
+         cout << "(reduced to " << N/(1 << 20) << " MiB, " << phys_bytes/1000000 << " MB RAM)\n";
+      }
+      std::string text(N, ' ');
+      splitmix64_stream rng{3};
+      for (size_t i = 0; i < N; ) {
+         const uint64_t r = rng();
+         const size_t len = std::min<size_t>(r & 15, N - i);
+         for (size_t k = 0; k < len; ++k) text[i+k] = (r >> (8 + k % 8)) & 1 ? 'a' + (r >> (16 + 3*(k % 12))) % 26 : ' ';
+         i += len;
+         if (i < N) text[i++] = (r >> 60) == 0 ? ';' : ':';
+      }
+      size_t n_tokens = 0, n_bytes = 0;
+      // n_tokens is only known after the measurement
+      auto report = [&](const std::string& name, const bench_stats& st) {
+         cout << std::setw(48) << std::left << name << std::right << std::setw(9) << std::fixed << std::setprecision(1)
+              << st.median/1e6 << " ms  " << std::setprecision(2) << (double) N/st.median << " GB/s  "
+              << n_tokens << " tokens\n" << std::defaultfloat << std::setprecision(6);
+      };
+      bench_harness bench(0, 1);
+      report("getline() on an istringstream (incl. its copy)", bench.measure([&]{
+         n_tokens = n_bytes = 0;
+         std::istringstream iss(text);
+         std::string token;
+         while (getline(iss, token, ':')) {
+            ++n_tokens;
+            n_bytes += token.find_first_not_of(' ') == std::string::npos ? 0 : token.size();
+         }
+         n_tokens += text.back() == ':';
+      }));
+      report("split(text, ':', BLANK_TO_EMPTY)", bench.measure([&]{
+         n_tokens = n_bytes = 0;
+         for (const auto t : split(text, ':', SPLIT_TRIM::BLANK_TO_EMPTY)) {
+            ++n_tokens;
+            n_bytes += t.size();
+         }
+      }));
+      report("string_view::find_first_of(\":;\") loop", bench.measure([&]{
+         n_tokens = n_bytes = 0;
+         const std::string_view sv = text;
+         for (size_t pos = 0; ; ) {
+            const size_t sep = sv.find_first_of(":;", pos);
+            ++n_tokens;
+            n_bytes += (sep == std::string_view::npos ? sv.size() : sep) - pos;
+            if (sep == std::string_view::npos) break;
+            pos = sep + 1;
+         }
+      }));
+      report("split(text, \":;\")", bench.measure([&]{
+         n_tokens = n_bytes = 0;
+         for (const auto t : split(text, ":;")) {
+            ++n_tokens;
+            n_bytes += t.size();
+         }
+      }));
+      do_not_optimize(n_bytes);
+   }
+}
+
+void testing_icase_search()
+{
+   {
+      const std::string s = "The C++ Standard Library: A Tutorial and Reference";
+      for (const std::string query : {"tutorial", "Tutorial", "C++ STANDARD", "reference!", "A TUTORIAL AND REFERENCE, 2nd edition"}) {
+         const ascii_icase_searcher searcher(query);
+         const auto pos = std::search(s.cbegin(), s.cend(), searcher);
+         cout << "query (search case-insensitive): \"" << query << "\" => ";
+         if (pos == s.cend()) {
+            cout << "not found\n";
+         } else {
+            cout << "found @pos " << (pos - s.cbegin()) << "\n";
+         }
+      }
+      // the SIMD filter and Horspool against the toupper lambda, random haystacks over a small alphabet
+      splitmix64_stream rng{11};
+      const std::string alphabet = "aAbB@`[{ ";
+      bool same = true;
+      for (int trial = 0; trial < 2000; ++trial) {
+         std::string hay(rng() % 300, ' '), needle(1 + rng() % 40, ' ');
+         for (auto& c : hay) c = alphabet[rng() % alphabet.size()];
+         for (auto& c : needle) c = alphabet[rng() % (trial % 2 ? 4 : alphabet.size())];
+         const auto expected = std::search(hay.cbegin(), hay.cend(), needle.cbegin(), needle.cend(),
+                                           [](char a, char b) { return std::toupper(a)==std::toupper(b); });
+         same &= std::search(hay.cbegin(), hay.cend(), ascii_icase_searcher(needle)) == expected;
+         same &= std::search(hay.cbegin(), hay.cend(), ascii_icase_searcher(needle, 0)) == expected;
+      }
+      cout << "ascii_icase_searcher == std::search with toupper(), 2000 random cases: " << (same ? "yes" : "NO") << "\n";
+   }
+   cout << "–––\n";
+   {
+      // 256 MiB of words, capitalized now and then; all matches of needles of 8, 16 and 45 chars
+      const std::vector<std::string> words = {
+         "the", "standard", "library", "a", "tutorial", "and", "reference", "of", "containers", "iterators",
+         "algorithms", "strings", "streams", "with", "for", "to", "in", "is", "that", "it", "concurrency",
+         "allocators", "numerics", "regular", "expressions", "utilities", "tut", "lib", "stan", "ref"
+      };
+      const size_t N = 1UL << 28;
+      std::string text;
+      text.reserve(N + 16);
+      splitmix64_stream rng{12};
+      while (text.size() < N) {
+         const uint64_t r = rng();
+         std::string w = words[r % words.size()];
+         if ((r >> 32) % 8 == 0) w[0] = std::toupper(w[0]);
+         if ((r >> 40) % 64 == 0) for (auto& c : w) c = std::toupper(c);
+         text += w;
+         text += (r >> 50) % 16 == 0 ? ". " : " ";
+      }
+      text.resize(N);
+      auto report = [&](const std::string& name, const bench_stats& st, size_t n_matches) {
+         cout << std::setw(58) << std::left << name << std::right << std::setw(9) << std::fixed << std::setprecision(1)
+              << st.median/1e6 << " ms  " << std::setprecision(2) << (double) N/st.median << " GB/s  "
+              << n_matches << " matches\n" << std::defaultfloat << std::setprecision(6);
+      };
+      // all (overlapping) matches, search(first, last) returns the first match in [first, last)
+      auto count_matches = [&](auto search) {
+         size_t n = 0;
+         for (auto it = search(text.cbegin(), text.cend()); it != text.cend(); it = search(it + 1, text.cend())) ++n;
+         return n;
+      };
+      bench_harness bench(0, 1);
+      for (const std::string needle : {"TUTORIAL", "Standard Library", "the standard library: a tutorial and referenc"}) {
+         cout << "needle \"" << needle << "\" (" << needle.size() << " chars):\n";
+         size_t n = 0;
+         auto st = bench.measure([&]{
+            n = count_matches([&](auto first, auto last) {
+               return std::search(first, last, needle.cbegin(), needle.cend(),
+                                  [](char a, char b) { return std::toupper(a)==std::toupper(b); });
+            });
+         });
+         report("  std::search, toupper lambda", st, n);
+         const std::boyer_moore_horspool_searcher bmh(needle.cbegin(), needle.cend(),
+            [](char c) { return std::hash<int>()(std::toupper(c)); },
+            [](char a, char b) { return std::toupper(a)==std::toupper(b); });
+         st = bench.measure([&]{
+            n = count_matches([&](auto first, auto last) { return bmh(first, last).first; });
+         });
+         report("  std::boyer_moore_horspool_searcher, toupper hash/pred", st, n);
+         for (const size_t horspool_min_len : {ascii_icase_searcher::NO_HORSPOOL, size_t(0)}) {
+            const ascii_icase_searcher icase(needle, horspool_min_len);
+            st = bench.measure([&]{
+               n = count_matches([&](auto first, auto last) { return icase(first, last).first; });
+            });
+            report(std::string("  ascii_icase_searcher") + (horspool_min_len == 0 ? ", Horspool" : ""), st, n);
+         }
+      }
+   }
+}
+
+void testing_rewrite_extensions()
+{
+   const char* kind_names[] = { "NONE", "EMPTY", "SAME", "OTHER", "NO_NAME" };
+   {
+      // the names of p.656, plus paths
+      const std::vector<std::string> strings = {
+         "prog.dat", "mydir", "hello.", "oops.tmp", "end.dat", "some.file.name.multiple.dots",
+         "src/v1.2/main.cpp", "home/user/.bashrc", "build/..", "archive.tar.gz"
+      };
+      rewritten_paths renamed;
+      for (const EXT_DOT which : {EXT_DOT::FIRST, EXT_DOT::LAST}) {
+         renamed.rewrite(strings, "tmp", which);
+         cout << (which == EXT_DOT::FIRST ? "first '.':\n" : "last '.':\n");
+         for (size_t i = 0; i < renamed.size(); ++i) {
+            cout << "  " << std::setw(30) << std::left << strings[i] << std::setw(8) << kind_names[(int) renamed.kind(i)]
+                 << std::right << " => " << renamed[i] << "\n";
+         }
+      }
+   }
+   cout << "–––\n";
+   {
+      // 2 million paths as from a directory walk
+      const size_t N = 2000000;
+      const std::vector<std::string> exts = { "cpp", "h", "tmp", "txt", "", "tar.gz", "o" };
+      std::vector<std::string> paths;
+      paths.reserve(N);
+      splitmix64_stream rng{21};
+      for (size_t i = 0; i < N; ++i) {
+         const uint64_t r = rng();
+         std::string p = "project/module_" + std::to_string(r % 97) + "/src.d/file_" + std::to_string(i);
+         const std::string& ext = exts[(r >> 32) % exts.size()];
+         if (!ext.empty()) p += "." + ext;
+         else if ((r >> 40) % 2) p += ".";
+         paths.push_back(std::move(p));
+      }
+      const std::string suffix = "tmp";
+      std::vector<std::string> result_copies;
+      rewritten_paths renamed;
+      bench_harness bench(1, 5);
+      // as p.656: substr() into base_name and ext_name, a copy into 'tmp' to replace the extension
+      auto rewrite_copies = [&]{
+         result_copies.clear();
+         for (const auto& s : paths) {
+            const size_t slash = s.rfind('/');
+            const size_t idx = s.find('.', slash == std::string::npos ? 0 : slash + 1);
+            if (idx == std::string::npos) {
+               result_copies.push_back(s + "." + suffix);
+               continue;
+            }
+            std::string base_name = s.substr(0,idx);
+            std::string ext_name = s.substr(idx+1);
+            if (ext_name == suffix) {
+               result_copies.push_back(s);
+            } else {
+               std::string tmp = s;
+               tmp.replace(idx+1, std::string::npos, suffix);
+               result_copies.push_back(std::move(tmp));
+            }
+         }
+      };
+      auto rewrite_arena = [&]{ renamed.rewrite(paths, suffix); };
+      auto report = [&](const std::string& name, const bench_stats& st, const std::function<void()>& f) {
+         size_t n_alloc = 0;
+         {
+            const allocation_counter allocations;
+            f();   // once more, now counting its allocations
+            n_alloc = allocations.count();
+         }
+         cout << std::setw(46) << std::left << name << std::right << std::setw(8) << std::fixed << std::setprecision(1)
+              << st.median/1e6 << " ms  " << std::setprecision(1) << (double) st.median/N << " ns/path  "
+              << n_alloc << " allocations\n" << std::defaultfloat << std::setprecision(6);
+      };
+      result_copies.reserve(N);
+      report("p.656: substr copies, std::vector<std::string>", bench.measure(rewrite_copies), rewrite_copies);
+      report("rewritten_paths, one arena", bench.measure(rewrite_arena), rewrite_arena);
+      bool same = renamed.size() == result_copies.size();
+      for (size_t i = 0; same && i < N; ++i) same = renamed[i] == result_copies[i];
+      cout << "same paths: " << (same ? "yes" : "NO") << ", arena: " << renamed.arena_bytes()/1000000 << " MB\n";
+      const allocation_counter allocations;
+      rewritten_paths fresh;
+      fresh.rewrite(paths, suffix);
+      cout << "a new rewritten_paths (no capacity yet): " << allocations.count() << " allocations\n";
+   }
+}
+
 void testing_stream_redirect()
 {
    cout << "first row\n";
@@ -3975,18 +8385,427 @@ void testing_string_conversions()
 }
 
 
-template <typename Distribution, typename Engine>
-void show_dist(Distribution d, Engine e, const std::string& name)
+// for 'testing_random_batch'
+/*
+   xoshiro256** (Blackman, Vigna 2018): 256 bit state, period 2^256-1, 64-bit output
+   - only shifts, xors, rotations and *5, *9 (= shift+add) => maps 1:1 onto AVX2 (which has no 64-bit multiply)
+   - jump() advances the state by 2^128 steps, long_jump() by 2^192
+     => up to 2^64 non-overlapping streams of 2^128 numbers each, e.g. one per thread
+   - seeded via splitmix64 (the state must not be all 0 bits)
+*/
+inline uint64_t rotl64(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+class xoshiro256ss {
+public:
+   using result_type = uint64_t;
+   using state_type = std::array<uint64_t,4>;
+
+   explicit xoshiro256ss(uint64_t seed = 1) {
+      splitmix64_stream sm{seed};
+      for (auto& w : m_s) w = sm();
+   }
+
+   static constexpr result_type min() { return 0; }
+   static constexpr result_type max() { return ~result_type(0); }
+   result_type operator()() {
+      const uint64_t result = rotl64(m_s[1]*5, 7)*9;
+      const uint64_t t = m_s[1] << 17;
+      m_s[2] ^= m_s[0];
+      m_s[3] ^= m_s[1];
+      m_s[1] ^= m_s[2];
+      m_s[0] ^= m_s[3];
+      m_s[2] ^= t;
+      m_s[3] = rotl64(m_s[3], 45);
+      return result;
+   }
+   void fill(uint64_t* out, size_t n) {
+      for (size_t i = 0; i < n; ++i) out[i] = (*this)();
+   }
+   void jump()      { jump_by({ 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL }); }
+   void long_jump() { jump_by({ 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL }); }
+   const state_type& state() const { return m_s; }
+
+private:
+   // the jump polynomial applied to the state: xor of the states at the set bits of 'poly'
+   void jump_by(const state_type& poly) {
+      state_type s = { 0, 0, 0, 0 };
+      for (const uint64_t word : poly) {
+         for (int b = 0; b < 64; ++b) {
+            if (word & (1ULL << b)) {
+               for (int k = 0; k < 4; ++k) s[k] ^= m_s[k];
+            }
+            (*this)();
+         }
+      }
+      m_s = s;
+   }
+
+   state_type m_s;
+};
+/*
+   xoshiro256ss_x4: 4 xoshiro256** generators in the 4 64-bit lanes of an AVX2 register
+   - lane i starts at xoshiro256ss(seed) jumped i times (2^128 numbers apart => no overlap)
+   - stream k: the base generator long_jump()ed k times => independent per-thread streams of 4 lanes each
+   - fill(): out[4*j+i] = j-th number of lane i; AVX2 if the CPU has it, else the same numbers lane by lane
+     a tail of n%4 numbers takes one more step of all lanes, the surplus numbers are dropped
+*/
+class xoshiro256ss_x4 {
+public:
+   explicit xoshiro256ss_x4(uint64_t seed = 1, uint64_t stream = 0) {
+      xoshiro256ss base(seed);
+      for (uint64_t k = 0; k < stream; ++k) base.long_jump();
+      for (int lane = 0; lane < 4; ++lane) {
+         for (int w = 0; w < 4; ++w) m_s[w][lane] = base.state()[w];
+         base.jump();
+      }
+   }
+
+   void fill(uint64_t* out, size_t n) {
+      if (cpu_has_avx2()) {
+         fill_avx2(out, n);
+      } else {
+         fill_scalar(out, n);
+      }
+   }
+
+private:
+   void fill_scalar(uint64_t* out, size_t n) {
+      uint64_t tail[4];
+      for (size_t i = 0; i < n; i += 4) {
+         uint64_t* dst = i + 4 <= n ? out + i : tail;
+         for (int lane = 0; lane < 4; ++lane) {
+            dst[lane] = rotl64(m_s[1][lane]*5, 7)*9;
+            const uint64_t t = m_s[1][lane] << 17;
+            m_s[2][lane] ^= m_s[0][lane];
+            m_s[3][lane] ^= m_s[1][lane];
+            m_s[1][lane] ^= m_s[2][lane];
+            m_s[0][lane] ^= m_s[3][lane];
+            m_s[2][lane] ^= t;
+            m_s[3][lane] = rotl64(m_s[3][lane], 45);
+         }
+         if (dst == tail) std::copy(tail, tail + (n - i), out + i);
+      }
+   }
+   template <int K>
+   __attribute__((target("avx2")))
+   static __m256i rotl64_avx2(__m256i x) {
+      return _mm256_or_si256(_mm256_slli_epi64(x, K), _mm256_srli_epi64(x, 64 - K));
+   }
+   __attribute__((target("avx2")))
+   void fill_avx2(uint64_t* out, size_t n) {
+      __m256i s0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_s[0]));
+      __m256i s1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_s[1]));
+      __m256i s2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_s[2]));
+      __m256i s3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_s[3]));
+      for (size_t i = 0; i < n; i += 4) {
+         const __m256i x5 = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);        // s1*5
+         const __m256i r = rotl64_avx2<7>(x5);
+         const __m256i result = _mm256_add_epi64(_mm256_slli_epi64(r, 3), r);      // *9
+         const __m256i t = _mm256_slli_epi64(s1, 17);
+         s2 = _mm256_xor_si256(s2, s0);
+         s3 = _mm256_xor_si256(s3, s1);
+         s1 = _mm256_xor_si256(s1, s2);
+         s0 = _mm256_xor_si256(s0, s3);
+         s2 = _mm256_xor_si256(s2, t);
+         s3 = rotl64_avx2<45>(s3);
+         if (i + 4 <= n) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+         } else {
+            alignas(32) uint64_t tail[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(tail), result);
+            std::copy(tail, tail + (n - i), out + i);
+         }
+      }
+      _mm256_store_si256(reinterpret_cast<__m256i*>(m_s[0]), s0);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(m_s[1]), s1);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(m_s[2]), s2);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(m_s[3]), s3);
+   }
+
+   alignas(32) uint64_t m_s[4][4];   // [state word][lane]
+};
+/*
+   batched sampling with the semantics of the <random> distributions, on whole buffers
+   - Engine: anything with fill(uint64_t*, n); the random bits are generated in chunks into a uint64_t
+     buffer on the stack and converted into the output (not in place: that would write uint64_t
+     through a double*) => no per-sample call through the engine and the distribution object
+   - fill_uniform(e, out, n, a, b):     uniform_real_distribution<double>(a,b), i.e. in [a,b)
+     53 random bits per double like generate_canonical<double,53>: (bits >> 11) * 2^-53
+   - fill_normal(e, out, n, mean, sd):  normal_distribution<double>(mean,sd), polar method on pairs of uniforms
+   - fill_exponential(e, out, n, l):    exponential_distribution<double>(l), -log(1-u)/l
+   => same distributions, but not the same sequences as <random> (e.g. normal_distribution caches its 2nd sample)
+   - the uint64 -> double conversion is vectorized (AVX2 has no such instruction: both 32-bit halves are
+     or'ed into the mantissa of 2^52, which is subtracted again), log/sqrt are the scalar libm ones
+*/
+inline double canonical_from_bits(uint64_t bits) { return (bits >> 11) * 0x1.0p-53; }
+__attribute__((target("avx2")))
+inline void canonical_from_bits_avx2(const uint64_t* bits, double* out, size_t n)
 {
-   cout << name << ":\n";
-   cout << " min: " << d.min() << "\n";
-   cout << " max: " << d.max() << "\n";
+   const __m256i exp52 = _mm256_set1_epi64x(0x4330000000000000LL);   // bit pattern of 2^52
+   const __m256d two52 = _mm256_set1_pd(0x1.0p52);
+   const __m256i lo32 = _mm256_set1_epi64x(0xffffffffLL);
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      const __m256i x = _mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits + i)), 11);
+      const __m256d lo = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(x, lo32), exp52)), two52);
+      const __m256d hi = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(x, 32), exp52)), two52);
+      const __m256d d = _mm256_add_pd(_mm256_mul_pd(hi, _mm256_set1_pd(0x1.0p32)), lo);   // exact, < 2^53
+      _mm256_storeu_pd(out + i, _mm256_mul_pd(d, _mm256_set1_pd(0x1.0p-53)));
+   }
+   for (; i < n; ++i) {
+      out[i] = canonical_from_bits(bits[i]);
+   }
+}
+// n uniforms in [0,1) from n random uint64
+inline void canonical_from_bits(const uint64_t* bits, double* out, size_t n)
+{
+   if (cpu_has_avx2()) {
+      canonical_from_bits_avx2(bits, out, n);
+      return;
+   }
+   for (size_t i = 0; i < n; ++i) {
+      out[i] = canonical_from_bits(bits[i]);
+   }
+}
+// chunks of 256 (a multiple of 4, so a lane-parallel engine yields the same stream as with one fill())
+template <typename Engine>
+void fill_canonical(Engine& e, double* out, size_t n)
+{
+   constexpr size_t CHUNK = 256;
+   alignas(32) uint64_t bits[CHUNK];
+   for (size_t i = 0; i < n; i += CHUNK) {
+      const size_t m = std::min(CHUNK, n - i);
+      e.fill(bits, m);
+      canonical_from_bits(bits, out + i, m);
+   }
+}
+template <typename Engine>
+void fill_uniform(Engine& e, double* out, size_t n, double a = 0.0, double b = 1.0)
+{
+   fill_canonical(e, out, n);
+   const double width = b - a;
+   for (size_t i = 0; i < n; ++i) out[i] = a + width*out[i];
+}
+template <typename Engine>
+void fill_normal(Engine& e, double* out, size_t n, double mean = 0.0, double stddev = 1.0)
+{
+   // Marsaglia polar method on the buffer itself: pairs are read at r, the accepted ones written at w <= r,
+   // (~21% of the pairs are rejected), the rest of the buffer is refilled until n samples are written
+   size_t w = 0;
+   while (w < n) {
+      fill_canonical(e, out + w, n - w);
+      for (size_t r = w; r + 2 <= n && w < n; r += 2) {
+         const double x = 2*out[r] - 1;
+         const double y = 2*out[r+1] - 1;
+         const double s = x*x + y*y;
+         if (s >= 1.0 || s == 0.0) continue;
+         const double f = std::sqrt(-2*std::log(s)/s);
+         out[w++] = mean + stddev*x*f;
+         if (w < n) out[w++] = mean + stddev*y*f;
+      }
+      if (w + 1 == n) {   // an odd last sample: no pair left in the buffer
+         double u[2];
+         do {
+            fill_canonical(e, u, 2);
+            u[0] = 2*u[0] - 1;
+            u[1] = 2*u[1] - 1;
+         } while (u[0]*u[0] + u[1]*u[1] >= 1.0 || u[0]*u[0] + u[1]*u[1] == 0.0);
+         const double s = u[0]*u[0] + u[1]*u[1];
+         out[w++] = mean + stddev*u[0]*std::sqrt(-2*std::log(s)/s);
+      }
+   }
+}
+template <typename Engine>
+void fill_exponential(Engine& e, double* out, size_t n, double lambda = 1.0)
+{
+   fill_canonical(e, out, n);
+   for (size_t i = 0; i < n; ++i) out[i] = -std::log(1.0 - out[i])/lambda;   // 1-u is exact, in (0,1]
+}
+void testing_random_batch()
+{
+   {
+      // the 4 AVX2 lanes are the scalar generator and its jumps
+      xoshiro256ss_x4 x4(42);
+      std::vector<uint64_t> out(4*1000 + 3);
+      x4.fill(out.data(), out.size());
+      xoshiro256ss lane(42);
+      bool same = true;
+      for (int i = 0; i < 4; ++i) {
+         xoshiro256ss ref = lane;
+         for (size_t j = i; j < out.size(); j += 4) same &= out[j] == ref();
+         lane.jump();
+      }
+      cout << "xoshiro256ss_x4: lane i == xoshiro256ss jumped i times: " << (same ? "yes" : "NO") << "\n";
+   }
+   {
+      // moments: batched vs <random>
+      const size_t N = 10000000;
+      std::vector<double, default_init_allocator<double>> buf(N);
+      auto moments = [&](const std::string& name, double mean, double var) {
+         double sum = 0.0, sum_sq = 0.0;
+         for (const double x : buf) { sum += x; sum_sq += x*x; }
+         const double m = sum/N;
+         cout << std::setw(44) << std::left << name << std::right << " mean " << std::setw(9) << m
+              << " (" << mean << ")  var " << std::setw(9) << sum_sq/N - m*m << " (" << var << ")\n";
+      };
+      std::mt19937_64 mt;
+      xoshiro256ss_x4 x4(1);
+      std::uniform_real_distribution<double> d_uniform(-1.0, 3.0);
+      for (auto& x : buf) x = d_uniform(mt);
+      moments("uniform_real_distribution(-1,3), mt19937_64", 1.0, 16.0/12);
+      fill_uniform(x4, buf.data(), N, -1.0, 3.0);
+      moments("fill_uniform(-1,3), xoshiro256ss_x4", 1.0, 16.0/12);
+      std::normal_distribution<double> d_normal(5.0, 2.0);
+      for (auto& x : buf) x = d_normal(mt);
+      moments("normal_distribution(5,2), mt19937_64", 5.0, 4.0);
+      fill_normal(x4, buf.data(), N, 5.0, 2.0);
+      moments("fill_normal(5,2), xoshiro256ss_x4", 5.0, 4.0);
+      std::exponential_distribution<double> d_exp(4.0);
+      for (auto& x : buf) x = d_exp(mt);
+      moments("exponential_distribution(4), mt19937_64", 0.25, 1.0/16);
+      fill_exponential(x4, buf.data(), N, 4.0);
+      moments("fill_exponential(4), xoshiro256ss_x4", 0.25, 1.0/16);
+   }
+   cout << "–––\n";
+   {
+      // samples/sec
+      const size_t N = 1 << 24;
+      std::vector<uint64_t, default_init_allocator<uint64_t>> bits(N);
+      std::vector<double, default_init_allocator<double>> buf(N);
+      bench_harness bench(1, 5);
+      auto report = [&](const std::string& name, const bench_stats& st) {
+         cout << std::setw(52) << std::left << name << std::right << std::setw(8) << std::fixed << std::setprecision(1)
+              << 1e3*N/st.median << " M samples/s  (" << (double) st.median/N << " ns/sample)\n" << std::defaultfloat << std::setprecision(6);
+      };
+      std::default_random_engine dre;
+      std::mt19937 mt;
+      std::mt19937_64 mt64;
+      xoshiro256ss xs;
+      xoshiro256ss_x4 x4;
+      report("raw: default_random_engine (31 bit)", bench.measure([&]{ for (auto& b : bits) b = dre(); do_not_optimize(bits.data()); }));
+      report("raw: mt19937 (32 bit)",               bench.measure([&]{ for (auto& b : bits) b = mt(); do_not_optimize(bits.data()); }));
+      report("raw: mt19937_64",                     bench.measure([&]{ for (auto& b : bits) b = mt64(); do_not_optimize(bits.data()); }));
+      report("raw: xoshiro256ss",                   bench.measure([&]{ xs.fill(bits.data(), N); do_not_optimize(bits.data()); }));
+      report("raw: xoshiro256ss_x4",                bench.measure([&]{ x4.fill(bits.data(), N); do_not_optimize(bits.data()); }));
+      cout << "–––\n";
+      std::uniform_real_distribution<double> d_uniform;
+      std::normal_distribution<double> d_normal;
+      std::exponential_distribution<double> d_exp;
+      report("uniform: uniform_real_distribution, default_random_engine", bench.measure([&]{ for (auto& x : buf) x = d_uniform(dre); do_not_optimize(buf.data()); }));
+      report("uniform: uniform_real_distribution, mt19937",     bench.measure([&]{ for (auto& x : buf) x = d_uniform(mt); do_not_optimize(buf.data()); }));
+      report("uniform: fill_uniform, xoshiro256ss_x4",          bench.measure([&]{ fill_uniform(x4, buf.data(), N); do_not_optimize(buf.data()); }));
+      report("normal:  normal_distribution, default_random_engine", bench.measure([&]{ for (auto& x : buf) x = d_normal(dre); do_not_optimize(buf.data()); }));
+      report("normal:  normal_distribution, mt19937",           bench.measure([&]{ for (auto& x : buf) x = d_normal(mt); do_not_optimize(buf.data()); }));
+      report("normal:  fill_normal, xoshiro256ss_x4",           bench.measure([&]{ fill_normal(x4, buf.data(), N); do_not_optimize(buf.data()); }));
+      report("exp:     exponential_distribution, default_random_engine", bench.measure([&]{ for (auto& x : buf) x = d_exp(dre); do_not_optimize(buf.data()); }));
+      report("exp:     exponential_distribution, mt19937",      bench.measure([&]{ for (auto& x : buf) x = d_exp(mt); do_not_optimize(buf.data()); }));
+      report("exp:     fill_exponential, xoshiro256ss_x4",      bench.measure([&]{ fill_exponential(x4, buf.data(), N); do_not_optimize(buf.data()); }));
+   }
+}
 
-   std::map<long,int> value_counter;
-   for (size_t i=0; i<20000; ++i) {
-      ++value_counter[d(e)];
+// for 'show_dist' and 'testing_histogram'
+/*
+   histogram: counts of long values in one contiguous array
+   => a bin index computation and an increment per sample, instead of a tree lookup
+      (and a node allocation for every new value) of ++std::map<long,int>[v]
+   - FIXED_WIDTH: bins [lo + i*width, lo + (i+1)*width) up to hi (inclusive)
+   - LOG_LINEAR (HDR histogram style), values in [0, max_value]:
+     values < 2^sub_bits get a bin each, every further power of 2 [2^k, 2^(k+1)) is split into
+     2^sub_bits equal bins => the bin width is at most 2^-sub_bits of the value, over the whole range
+     (the bins have different widths: counts are not densities)
+   - values outside the bins are counted in underflow/overflow
+   - merge(): adds a histogram with the same bins, e.g. per-thread sub-histograms at the end
+*/
+class histogram {
+public:
+   enum class BINNING { FIXED_WIDTH, LOG_LINEAR };
+
+   static histogram fixed_width(long lo, long hi, long width = 1) {
+      assert(lo <= hi && width >= 1);
+      return histogram(BINNING::FIXED_WIDTH, lo, width, 0, ((uint64_t) hi - (uint64_t) lo)/width + 1);
+   }
+   static histogram log_linear(long max_value, int sub_bits = 5) {
+      assert(max_value >= 0 && sub_bits >= 0 && sub_bits < 32);
+      histogram h(BINNING::LOG_LINEAR, 0, 1, sub_bits, 0);
+      h.m_counts.resize(h.log_linear_bin(max_value) + 1);
+      return h;
+   }
+
+   void add(long v) {
+      if (v < m_lo) {
+         ++m_underflow;
+         return;
+      }
+      const uint64_t x = (uint64_t) v - (uint64_t) m_lo;
+      const uint64_t bin = m_binning == BINNING::LOG_LINEAR ? log_linear_bin(x) : (m_width == 1 ? x : x/m_width);
+      if (bin < m_counts.size()) {
+         ++m_counts[bin];
+      } else {
+         ++m_overflow;
+      }
+   }
+   void merge(const histogram& other) {
+      assert(m_binning == other.m_binning && m_lo == other.m_lo && m_width == other.m_width
+             && m_sub_bits == other.m_sub_bits && m_counts.size() == other.m_counts.size());
+      for (size_t i = 0; i < m_counts.size(); ++i) m_counts[i] += other.m_counts[i];
+      m_underflow += other.m_underflow;
+      m_overflow += other.m_overflow;
+   }
+
+   size_t n_bins() const { return m_counts.size(); }
+   uint64_t count(size_t bin) const { return m_counts[bin]; }
+   long bin_lower(size_t bin) const {
+      if (m_binning == BINNING::FIXED_WIDTH) return m_lo + (long) bin*m_width;
+      const uint64_t n_sub = 1ULL << m_sub_bits;
+      if (bin < n_sub) return (long) bin;
+      const uint64_t group = bin >> m_sub_bits;   // >= 1
+      return (long) ((n_sub + (bin & (n_sub - 1))) << (group - 1));
+   }
+   uint64_t underflow() const { return m_underflow; }
+   uint64_t overflow() const { return m_overflow; }
+   uint64_t total() const {
+      return std::accumulate(m_counts.begin(), m_counts.end(), m_underflow + m_overflow);
+   }
+   // (lower bound of the bin, count) of the non-empty bins, in increasing order, like iterating a std::map
+   std::vector<std::pair<long,uint64_t>> nonzero_bins() const {
+      std::vector<std::pair<long,uint64_t>> bins;
+      for (size_t i = 0; i < m_counts.size(); ++i) {
+         if (m_counts[i]) bins.emplace_back(bin_lower(i), m_counts[i]);
+      }
+      return bins;
+   }
+
+private:
+   histogram(BINNING binning, long lo, long width, int sub_bits, size_t n_bins)
+      : m_binning(binning), m_lo(lo), m_width(width), m_sub_bits(sub_bits), m_counts(n_bins, 0) {}
+
+   uint64_t log_linear_bin(uint64_t x) const {
+      if (x < (1ULL << m_sub_bits)) return x;
+      const int k = 63 - __builtin_clzll(x);   // x in [2^k, 2^(k+1)), k >= sub_bits
+      return ((uint64_t) (k - m_sub_bits + 1) << m_sub_bits) + ((x >> (k - m_sub_bits)) - (1ULL << m_sub_bits));
    }
 
+   BINNING m_binning;
+   long m_lo;
+   long m_width;
+   int m_sub_bits;
+   std::vector<uint64_t> m_counts;
+   uint64_t m_underflow = 0;
+   uint64_t m_overflow = 0;
+};
+// merged histogram of n_chunks chunks, chunk c counted by fill(c, h) into its own histogram h (copy of 'layout')
+template <typename F>
+histogram parallel_histogram(const histogram& layout, size_t n_chunks, unsigned n_threads, F fill)
+{
+   std::vector<histogram> parts(n_chunks, layout);
+   parallel_for_index(n_chunks, n_threads, [&](size_t c) { fill(c, parts[c]); });
+   histogram merged = layout;
+   for (const auto& part : parts) merged.merge(part);
+   return merged;
+}
+// ASCII rendering of (value, count) pairs in increasing value order (a std::map<long,int> or histogram::nonzero_bins())
+template <typename Counts>
+void print_value_counts(const Counts& value_counter)
+{
    const auto [min,max] = std::minmax_element(
       value_counter.begin(), value_counter.end(),
       [](const auto& p1, const auto& p2) { // 'const auto&' instead of 'const std::pair<long,int>&'
@@ -4015,6 +8834,93 @@ void show_dist(Distribution d, Engine e, const std::string& name)
       cout << std::setw(3) << k << ": " << std::string(int((v-min->second)/counts_per_char)+offset, '+') << "\n";
    }
 }
+template <typename Distribution, typename Engine>
+void show_dist(Distribution d, Engine e, const std::string& name)
+{
+   cout << name << ":\n";
+   cout << " min: " << d.min() << "\n";
+   cout << " max: " << d.max() << "\n";
+
+   // bins of width 1 over [d.min(),d.max()], clamped to +-2^16 (cauchy has tails beyond any range)
+   // formerly: std::map<long,int> value_counter; ++value_counter[d(e)]; (see 'testing_histogram')
+   const double range = 1 << 16;
+   histogram value_counter = histogram::fixed_width(
+      (long) std::max<double>(d.min(), -range), (long) std::min<double>(d.max(), range));
+   for (size_t i=0; i<20000; ++i) {
+      value_counter.add((long) d(e));
+   }
+   print_value_counts(value_counter.nonzero_bins());
+   if (value_counter.underflow() + value_counter.overflow() > 0) {
+      cout << "outside of [" << -range << "," << range << "]: "
+           << value_counter.underflow() << " below, " << value_counter.overflow() << " above\n";
+   }
+}
+void testing_histogram()
+{
+   {
+      // HDR: latencies with a long tail, 4 bins per power of 2
+      xoshiro256ss_x4 e(7);
+      std::vector<double> latencies_ns(1000000);
+      fill_exponential(e, latencies_ns.data(), latencies_ns.size(), 1.0/2000);
+      histogram h = histogram::log_linear(1L << 20, 2);
+      for (const double x : latencies_ns) h.add((long) x);
+      cout << "exponential latencies, mean 2000 ns, log-linear bins (4 per power of 2), lower bounds:\n";
+      print_value_counts(h.nonzero_bins());
+   }
+   cout << "–––\n";
+   {
+      // 1e9 normal samples (sd 100 => ~1000 different values): std::map vs flat array
+      const size_t N = 1000000000;
+      const size_t block = 1 << 16;
+      const size_t n_blocks = N/block;
+      const unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+      // fills block by block, f(values, n) counts them
+      auto sample_blocks = [&](size_t first_block, size_t last_block, uint64_t stream, auto f) {
+         xoshiro256ss_x4 e(1, stream);
+         std::vector<double> buf(block);
+         std::vector<long> values(block);
+         for (size_t b = first_block; b < last_block; ++b) {
+            fill_normal(e, buf.data(), block, 0.0, 100.0);
+            std::copy(buf.begin(), buf.end(), values.begin());   // truncation to long, as ++map[d(e)]
+            f(values.data(), block);
+         }
+      };
+      auto report = [&](const std::string& name, const bench_stats& st) {
+         cout << std::setw(44) << std::left << name << std::right << std::setw(8) << std::fixed << std::setprecision(1)
+              << 1e3*n_blocks*block/st.median << " M samples/s  (" << (double) st.median/(n_blocks*block) << " ns/sample)\n"
+              << std::defaultfloat << std::setprecision(6);
+      };
+      bench_harness bench(0, 1);
+      long sink = 0;
+      report("sampling only", bench.measure([&]{
+         sample_blocks(0, n_blocks, 0, [&](const long* v, size_t n) { for (size_t i = 0; i < n; ++i) sink += v[i]; });
+         do_not_optimize(sink);
+      }));
+      std::map<long,int> value_counter;
+      report("sampling + ++std::map<long,int>[v]", bench.measure([&]{
+         value_counter.clear();
+         sample_blocks(0, n_blocks, 0, [&](const long* v, size_t n) { for (size_t i = 0; i < n; ++i) ++value_counter[v[i]]; });
+      }));
+      const histogram layout = histogram::fixed_width(-1000, 1000);
+      histogram flat = layout;
+      report("sampling + histogram::add(v)", bench.measure([&]{
+         flat = layout;
+         sample_blocks(0, n_blocks, 0, [&](const long* v, size_t n) { for (size_t i = 0; i < n; ++i) flat.add(v[i]); });
+      }));
+      histogram merged = layout;
+      report("sampling + histogram, " + std::to_string(n_threads) + " thread(s), merged", bench.measure([&]{
+         merged = parallel_histogram(layout, n_threads, n_threads, [&](size_t t, histogram& h) {
+            sample_blocks(t*n_blocks/n_threads, (t+1)*n_blocks/n_threads, t,
+                          [&](const long* v, size_t n) { for (size_t i = 0; i < n; ++i) h.add(v[i]); });
+         });
+      }));
+      const auto bins = flat.nonzero_bins();
+      const bool same = flat.underflow() + flat.overflow() == 0 && bins.size() == value_counter.size()
+                        && std::equal(bins.begin(), bins.end(), value_counter.begin(),
+                                      [](const auto& b, const auto& m) { return b.first == m.first && b.second == (uint64_t) m.second; });
+      cout << "histogram == std::map counts: " << (same ? "yes" : "NO") << ", merged total: " << merged.total() << "\n";
+   }
+}
 void testing_random()
 {
    std::default_random_engine dre;
@@ -4701,9 +9607,21 @@ int main(int argc, char* argv[])
    testing_timing();
    print_hline();
 
+   testing_bench_harness();
+   print_hline();
+
    testing_vector_capacity();
    print_hline();
 
+   testing_vector_capacity_bench();
+   print_hline();
+
+   testing_default_init_allocator();
+   print_hline();
+
+   testing_hugepage_allocator();
+   print_hline();
+
    test_operator_precedence();
    print_hline();
 
@@ -4734,33 +9652,81 @@ int main(int argc, char* argv[])
    testing_unordered_container_custom_hash();
    print_hline();
 
+   testing_flat_hash_map();
+   print_hline();
+
+   testing_hash_quality();
+   print_hline();
+
+   testing_hash_table_stats();
+   print_hline();
+
+   testing_heterogeneous_lookup();
+   print_hline();
+
+   testing_hash_cached();
+   print_hline();
+
    testing_container_reference_semantics();
    print_hline();
 
    testing_multiple_sorting_criteria();
    print_hline();
 
+   testing_multi_index_store();
+   print_hline();
+
+   testing_customer_table();
+   print_hline();
+
+   testing_multi_key_sort();
+   print_hline();
+
    testing_processing_adjacent_elements();
    print_hline();
 
+   testing_run_boundaries_bench();
+   print_hline();
+
    testing_shift_left();
    print_hline();
 
    testing_nth_element();
    print_hline();
 
+   testing_top_k();
+   print_hline();
+
    testing_next_permutation();
    print_hline();
 
+   testing_permutation_unranking();
+   print_hline();
+
    testing_shuffle();
    print_hline();
 
+   testing_merge_shuffle();
+   print_hline();
+
    testing_bitset();
    print_hline();
 
+   testing_dyn_bitset();
+   print_hline();
+
    testing_string();
    print_hline();
 
+   testing_split();
+   print_hline();
+
+   testing_icase_search();
+   print_hline();
+
+   testing_rewrite_extensions();
+   print_hline();
+
    testing_stream_redirect();
    print_hline();
 
@@ -4775,6 +9741,12 @@ int main(int argc, char* argv[])
    testing_random();
    print_hline();
 
+   testing_random_batch();
+   print_hline();
+
+   testing_histogram();
+   print_hline();
+
    testing_async_future();
    print_hline();
 